@@ -0,0 +1,258 @@
+#include <cctype>
+#include <cstdint>
+#include <format>
+
+#include "catalog.h"
+
+using namespace std;
+
+CatalogFormat catalogFormatFor(const std::string& filename) {
+    std::string extension = ".json";
+    if (filename.size() >= extension.size()
+        && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0) {
+        return CATALOG_JSON;
+    }
+    return CATALOG_TEXT;
+}
+
+CatalogReader::CatalogReader(std::string_view contents, CatalogFormat format)
+    : in(contents), catalogFormat(format) {
+    // The text reader counts lines as it reads them; the JSON reader counts newlines
+    lineNumber = format == CATALOG_JSON ? 1 : 0;
+}
+
+bool CatalogReader::next(std::string& id, std::string& message) {
+    if (finished) {
+        return false;
+    }
+    bool found = catalogFormat == CATALOG_JSON ? nextJSON(id, message) : nextText(id, message);
+    if (!found) {
+        finished = true;
+    }
+    return found;
+}
+
+bool CatalogReader::syntaxError(const std::string& message) {
+    if (errorMessage.empty()) {
+        errorMessage = format("line {}: {}", lineNumber, message);
+    }
+    return false;
+}
+
+// Text format
+
+bool CatalogReader::readLine(std::string_view& line) {
+    if (pos >= in.size()) {
+        return false;
+    }
+    size_t end = in.find('\n', pos);
+    if (end == std::string_view::npos) {
+        end = in.size();
+    }
+    line = in.substr(pos, end - pos);
+    pos = end + 1;
+    lineNumber++;
+    return true;
+}
+
+static bool isIndented(std::string_view line) {
+    return !line.empty() && (line[0] == ' ' || line[0] == '\t');
+}
+
+static bool isBlankOrComment(std::string_view line) {
+    size_t start = line.find_first_not_of(" \t\r");
+    return start == std::string::npos || (start == 0 && line[0] == '#');
+}
+
+static std::string_view trim(std::string_view s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+        return std::string_view();
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+bool CatalogReader::nextText(std::string& id, std::string& message) {
+    std::string_view line;
+    if (hasPendingLine) {
+        line = pendingLine;
+        hasPendingLine = false;
+    } else {
+        do {
+            if (!readLine(line)) {
+                return false;
+            }
+        } while (isBlankOrComment(line));
+    }
+    if (isIndented(line)) {
+        return syntaxError("continuation line doesn't follow a message");
+    }
+    size_t equals = line.find('=');
+    if (equals == std::string_view::npos) {
+        return syntaxError("expected `id = message`");
+    }
+    id = trim(line.substr(0, equals));
+    if (id.empty()) {
+        return syntaxError("missing message ID");
+    }
+    message = trim(line.substr(equals + 1));
+    message.push_back('\n');
+
+    while (readLine(line)) {
+        if (isBlankOrComment(line) && !isIndented(line)) {
+            continue;
+        }
+        if (!isIndented(line)) {
+            pendingLine = line;
+            hasPendingLine = true;
+            break;
+        }
+        message += trim(line);
+        message.push_back('\n');
+    }
+    return true;
+}
+
+// JSON format
+
+void CatalogReader::skipJSONWhitespace() {
+    int c;
+    while ((c = peek()) == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        if (c == '\n') {
+            lineNumber++;
+        }
+        pos++;
+    }
+}
+
+static void appendUTF8(std::string& s, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        s.push_back(codePoint);
+    } else if (codePoint < 0x800) {
+        s.push_back(0xC0 | (codePoint >> 6));
+        s.push_back(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        s.push_back(0xE0 | (codePoint >> 12));
+        s.push_back(0x80 | ((codePoint >> 6) & 0x3F));
+        s.push_back(0x80 | (codePoint & 0x3F));
+    } else {
+        s.push_back(0xF0 | (codePoint >> 18));
+        s.push_back(0x80 | ((codePoint >> 12) & 0x3F));
+        s.push_back(0x80 | ((codePoint >> 6) & 0x3F));
+        s.push_back(0x80 | (codePoint & 0x3F));
+    }
+}
+
+// Reads the four hex digits of a \u escape
+bool CatalogReader::readUnicodeEscape(uint32_t& codeUnit) {
+    codeUnit = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = get();
+        if (!isxdigit(c)) {
+            return syntaxError("bad \\u escape");
+        }
+        codeUnit = codeUnit * 16 + (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+    }
+    return true;
+}
+
+bool CatalogReader::readJSONString(std::string& s) {
+    s.clear();
+    if (get() != '"') {
+        return syntaxError("expected a string");
+    }
+    int c;
+    while ((c = get()) != '"') {
+        if (c == EOF) {
+            return syntaxError("unterminated string");
+        }
+        if (c == '\n') {
+            return syntaxError("unescaped newline in string");
+        }
+        if (c != '\\') {
+            s.push_back(c);
+            continue;
+        }
+        c = get();
+        switch (c) {
+        case '"': case '\\': case '/':
+            s.push_back(c);
+            break;
+        case 'b': s.push_back('\b'); break;
+        case 'f': s.push_back('\f'); break;
+        case 'n': s.push_back('\n'); break;
+        case 'r': s.push_back('\r'); break;
+        case 't': s.push_back('\t'); break;
+        case 'u': {
+            uint32_t codeUnit;
+            if (!readUnicodeEscape(codeUnit)) {
+                return false;
+            }
+            // A surrogate must be a high surrogate, immediately followed
+            // by an escaped low surrogate; anything else would change the message
+            if (codeUnit >= 0xD800 && codeUnit < 0xDC00) {
+                uint32_t lowSurrogate;
+                if (get() != '\\' || get() != 'u') {
+                    return syntaxError("unpaired surrogate in \\u escape");
+                }
+                if (!readUnicodeEscape(lowSurrogate)) {
+                    return false;
+                }
+                if (lowSurrogate < 0xDC00 || lowSurrogate >= 0xE000) {
+                    return syntaxError("unpaired surrogate in \\u escape");
+                }
+                codeUnit = 0x10000 + ((codeUnit - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+            } else if (codeUnit >= 0xDC00 && codeUnit < 0xE000) {
+                return syntaxError("unpaired surrogate in \\u escape");
+            }
+            appendUTF8(s, codeUnit);
+            break;
+        }
+        default:
+            return syntaxError("bad escape sequence");
+        }
+    }
+    return true;
+}
+
+bool CatalogReader::nextJSON(std::string& id, std::string& message) {
+    skipJSONWhitespace();
+    if (!started) {
+        if (get() != '{') {
+            return syntaxError("expected '{' at start of catalog");
+        }
+        started = true;
+        skipJSONWhitespace();
+        if (peek() == '}') {
+            get();
+            return false;
+        }
+    } else {
+        int c = get();
+        if (c == '}') {
+            skipJSONWhitespace();
+            if (peek() != EOF) {
+                return syntaxError("unexpected text after end of catalog");
+            }
+            return false;
+        }
+        if (c != ',') {
+            return syntaxError("expected ',' or '}'");
+        }
+        skipJSONWhitespace();
+    }
+
+    if (!readJSONString(id)) {
+        return false;
+    }
+    skipJSONWhitespace();
+    if (get() != ':') {
+        return syntaxError("expected ':'");
+    }
+    skipJSONWhitespace();
+    if (peek() != '"') {
+        return syntaxError(format("value for message ID \"{}\" is not a string", id));
+    }
+    return readJSONString(message);
+}
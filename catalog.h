@@ -0,0 +1,71 @@
+// Streaming reader for message catalogs: files that hold many messages,
+// each identified by a message ID.
+//
+// Two formats are supported:
+//
+// * JSON: a single object whose keys are message IDs and whose values are
+//   messages, e.g. {"days": ".input {$n :number} ...", "hello": "Hello"}.
+//   Nested objects and non-string values are not allowed.
+//
+// * Text: each message starts on a line of the form `id = message`.
+//   The message continues on the following lines that begin with a space
+//   or tab; their leading whitespace is removed. Lines that are blank or
+//   that begin with `#` are ignored.
+//
+// Entries are read one at a time from the catalog's contents (usually a
+// memory-mapped file; see MappedFile), so memory use doesn't depend on
+// the size of the catalog.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+enum CatalogFormat {
+    CATALOG_JSON,
+    CATALOG_TEXT
+};
+
+// Files whose names end in `.json` are JSON catalogs; all others are text catalogs
+CatalogFormat catalogFormatFor(const std::string& filename);
+
+class CatalogReader {
+public:
+    // `contents` must remain valid while the reader is in use
+    CatalogReader(std::string_view contents, CatalogFormat format);
+
+    // Reads the next entry into `id` and `message`. Returns false at the
+    // end of the catalog, or if the catalog is malformed (in which case
+    // error() is non-empty).
+    bool next(std::string& id, std::string& message);
+
+    // Describes the first syntax error found, or is empty if there is none
+    const std::string& error() const { return errorMessage; }
+
+private:
+    bool nextJSON(std::string& id, std::string& message);
+    bool nextText(std::string& id, std::string& message);
+    bool readLine(std::string_view& line);
+    bool readJSONString(std::string& s);
+    bool readUnicodeEscape(uint32_t& codeUnit);
+    void skipJSONWhitespace();
+    bool syntaxError(const std::string& message);
+
+    // Returns the next character without consuming it, or EOF at the end
+    int peek() const { return pos < in.size() ? static_cast<unsigned char>(in[pos]) : EOF; }
+    int get() { return pos < in.size() ? static_cast<unsigned char>(in[pos++]) : EOF; }
+
+    std::string_view in;
+    size_t pos = 0;
+    CatalogFormat catalogFormat;
+    std::string errorMessage;
+    int lineNumber;
+    // JSON: true once the opening '{' has been read
+    bool started = false;
+    bool finished = false;
+    // Text: the first line of the next entry, if it has already been read
+    std::string_view pendingLine;
+    bool hasPendingLine = false;
+};
@@ -0,0 +1,14 @@
+// Checks that validateMessages() runs on each message, for programs such as
+// mf2bench that time one check on its own. Not part of the library's
+// interface: the checks fail by throwing an exception of a type that only
+// libmf2validate.cpp knows, so callers can only catch it with `...`.
+
+#pragma once
+
+#include "libmf2validate.h"
+#include "messageview.h"
+
+// Checks `view` for the data model errors that have to do with variants, and
+// fails `result` with DATA_MODEL_ERROR at the first one. Other data model
+// errors aren't reported.
+void checkDataModelErrors(ValidationResult& result, MessageRole role, const MessageView& view);
@@ -0,0 +1,81 @@
+#include "coverage.h"
+
+uint64_t CategoryCoverage::tupleCount(int numCategories, int numSelectors) {
+    uint64_t count = 1;
+    for (int i = 0; i < numSelectors; i++) {
+        if (count > UINT64_MAX / numCategories) {
+            return UINT64_MAX;
+        }
+        count *= numCategories;
+    }
+    return count;
+}
+
+CategoryCoverage::CategoryCoverage(std::span<const PluralCategory> categories, int numSelectors)
+    : categories(categories.begin(), categories.end()), numSelectors(numSelectors) {}
+
+bool CategoryCoverage::add(std::span<const PluralCategory> keys) {
+    Region region { std::vector<PluralCategory>(keys.begin(), keys.end()), -1 };
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == CATEGORY_WILDCARD) {
+            continue;
+        }
+        bool found = false;
+        for (auto it = categories.begin(); it != categories.end(); ++it) {
+            found |= *it == keys[i];
+        }
+        if (!found) {
+            return false;
+        }
+        region.lastKey = static_cast<int>(i);
+    }
+    covered.push_back(region);
+    return true;
+}
+
+uint64_t CategoryCoverage::uncovered(std::vector<std::vector<PluralCategory>>& regions) const {
+    std::vector<const Region*> overlapping;
+    for (auto it = covered.begin(); it != covered.end(); ++it) {
+        overlapping.push_back(&*it);
+    }
+    std::vector<PluralCategory> prefix;
+    uint64_t count = 0;
+    findUncovered(prefix, overlapping, regions, count);
+    return count;
+}
+
+// `overlapping` holds the covered regions that include some tuple beginning with `prefix`
+void CategoryCoverage::findUncovered(std::vector<PluralCategory>& prefix,
+                                     const std::vector<const Region*>& overlapping,
+                                     std::vector<std::vector<PluralCategory>>& regions,
+                                     uint64_t& count) const {
+    int selector = prefix.size();
+    if (overlapping.empty()) {
+        // No tuple beginning with `prefix` is covered
+        std::vector<PluralCategory> region = prefix;
+        region.resize(numSelectors, CATEGORY_WILDCARD);
+        regions.push_back(region);
+        uint64_t size = tupleCount(categories.size(), numSelectors - selector);
+        count = (count > UINT64_MAX - size) ? UINT64_MAX : count + size;
+        return;
+    }
+    for (auto it = overlapping.begin(); it != overlapping.end(); ++it) {
+        if ((*it)->lastKey < selector) {
+            // This region includes every tuple beginning with `prefix`
+            return;
+        }
+    }
+    std::vector<const Region*> next;
+    for (auto category = categories.begin(); category != categories.end(); ++category) {
+        next.clear();
+        for (auto it = overlapping.begin(); it != overlapping.end(); ++it) {
+            PluralCategory key = (*it)->keys[selector];
+            if (key == CATEGORY_WILDCARD || key == *category) {
+                next.push_back(*it);
+            }
+        }
+        prefix.push_back(*category);
+        findUncovered(prefix, next, regions, count);
+        prefix.pop_back();
+    }
+}
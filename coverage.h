@@ -0,0 +1,52 @@
+// Tracks which tuples of plural categories are covered by a message's variants.
+//
+// For a message with n selectors, in a locale with k plural categories,
+// there are k^n tuples of categories. Each variant's keys describe a
+// hyper-rectangle in that space: a key that is a category fixes that
+// selector's value, and a `*` key spans all of the selector's values.
+// Uncovered tuples are found by splitting the space one selector at a time,
+// following only the variants that overlap the current region, so the
+// k^n tuples are never enumerated: a region that no variant overlaps is
+// reported as a whole, and a region that one variant spans is skipped.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "pluralcategories.h"
+
+class CategoryCoverage {
+public:
+    // Returns k^n, or UINT64_MAX if that doesn't fit in 64 bits
+    static uint64_t tupleCount(int numCategories, int numSelectors);
+
+    // `categories` are the locale's plural categories
+    CategoryCoverage(std::span<const PluralCategory> categories, int numSelectors);
+
+    // Marks the tuples matched by `keys` (in which CATEGORY_WILDCARD matches
+    // any category) as covered. Returns false, and marks nothing, if some key
+    // isn't one of the locale's categories.
+    bool add(std::span<const PluralCategory> keys);
+
+    // Appends the uncovered regions to `regions`, in the same form as the
+    // argument to add(), and returns the number of uncovered tuples
+    uint64_t uncovered(std::vector<std::vector<PluralCategory>>& regions) const;
+
+private:
+    struct Region {
+        std::vector<PluralCategory> keys;
+        // Index of the last key that isn't a wildcard, or -1 if there is none
+        int lastKey;
+    };
+
+    void findUncovered(std::vector<PluralCategory>& prefix,
+                       const std::vector<const Region*>& overlapping,
+                       std::vector<std::vector<PluralCategory>>& regions,
+                       uint64_t& count) const;
+
+    std::vector<PluralCategory> categories;
+    int numSelectors;
+    std::vector<Region> covered;
+};
@@ -0,0 +1,97 @@
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <set>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "filewatcher.h"
+
+using namespace std;
+
+FileWatcher::FileWatcher() : fd(inotify_init1(IN_CLOEXEC)) {}
+
+FileWatcher::~FileWatcher() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool FileWatcher::add(const std::string& filename, std::string& error) {
+    if (fd < 0) {
+        error = format("Error setting up inotify: {}", strerror(errno));
+        return false;
+    }
+    std::filesystem::path path(filename);
+    std::string directory = path.parent_path().string();
+    if (directory.empty()) {
+        directory = ".";
+    }
+    // Saving a file either writes it in place or moves another file over it
+    int watch = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0) {
+        error = format("Error watching directory {}: {}", directory, strerror(errno));
+        return false;
+    }
+    watches[watch][path.filename().string()].push_back(filename);
+    return true;
+}
+
+// Returns false if poll() fails; `ready` is set if there are events to read
+static bool waitForEvents(int fd, int timeoutMillis, bool& ready) {
+    struct pollfd request = { fd, POLLIN, 0 };
+    int n;
+    do {
+        n = poll(&request, 1, timeoutMillis);
+    } while (n < 0 && errno == EINTR);
+    ready = n > 0;
+    return n >= 0;
+}
+
+std::vector<std::string> FileWatcher::wait(int settleMillis, std::string& error) {
+    std::set<std::string> changed;
+    // Block indefinitely for the first change, then only for as long as
+    // changes keep arriving
+    int timeoutMillis = -1;
+    while (true) {
+        bool ready;
+        if (!waitForEvents(fd, timeoutMillis, ready)) {
+            error = format("Error waiting for file changes: {}", strerror(errno));
+            return {};
+        }
+        if (!ready) {
+            if (!changed.empty()) {
+                return std::vector<std::string>(changed.begin(), changed.end());
+            }
+            continue;
+        }
+
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = format("Error reading file changes: {}", strerror(errno));
+            return {};
+        }
+        for (char* p = buffer; p < buffer + length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end() || event->len == 0) {
+                continue;
+            }
+            auto names = watch->second.find(event->name);
+            if (names != watch->second.end()) {
+                changed.insert(names->second.begin(), names->second.end());
+            }
+        }
+        if (!changed.empty()) {
+            timeoutMillis = settleMillis;
+        }
+    }
+}
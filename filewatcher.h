@@ -0,0 +1,36 @@
+// Notification of changes to files, using inotify, for --watch mode.
+//
+// The directories that hold the files are watched rather than the files
+// themselves, so that a file that is saved by writing a new file and
+// renaming it over the old one, as many editors do, is still seen.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Starts watching `filename`. Returns false, and sets `error`, if its
+    // directory can't be watched.
+    bool add(const std::string& filename, std::string& error);
+
+    // Blocks until at least one watched file has been written or replaced,
+    // then waits until no more changes arrive for `settleMillis`, so that a
+    // save made of several writes is seen once. Returns the names of the files
+    // that changed, as they were given to add(), each once. Returns an empty
+    // vector, and sets `error`, if the changes can't be read.
+    std::vector<std::string> wait(int settleMillis, std::string& error);
+
+private:
+    int fd;
+    // For each watch descriptor, maps names of files in its directory to the
+    // names they were given to add() by
+    std::unordered_map<int, std::unordered_map<std::string, std::vector<std::string>>> watches;
+};
@@ -0,0 +1,124 @@
+// Generates pluraltables.h, which holds the cardinal plural categories of every
+// locale that ICU has data for, as constexpr tables, so that looking up a
+// locale's categories doesn't need a PluralRules object.
+//
+// Writes the header to standard output. Built and run by the Makefile against
+// the same ICU as the validator, so the tables match its CLDR data;
+// pluraltabletest checks that they still do.
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unicode/locid.h>
+#include <unicode/plurrule.h>
+#include <unicode/strenum.h>
+#include <unicode/ulocdata.h>
+#include <unicode/uversion.h>
+
+using namespace icu;
+using namespace std;
+
+// In the order of the PluralCategory enum
+static const char* categoryNames[] = {
+    "zero", "one", "two", "few", "many", "other"
+};
+
+static std::string versionToString(const UVersionInfo version) {
+    char buffer[U_MAX_VERSION_STRING_LENGTH];
+    u_versionToString(version, buffer);
+    return buffer;
+}
+
+// Returns the enumerator names of `locale`'s categories, in the order ICU returns them,
+// and sets `mask`. Returns an empty list if the categories can't be determined.
+static std::vector<std::string> localeCategories(const Locale& locale, uint32_t& mask) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    LocalPointer<PluralRules> rules(PluralRules::forLocale(locale, errorCode));
+    if (U_FAILURE(errorCode)) {
+        return {};
+    }
+    LocalPointer<StringEnumeration> keywords(rules->getKeywords(errorCode));
+    if (U_FAILURE(errorCode)) {
+        return {};
+    }
+    std::vector<std::string> categories;
+    mask = 0;
+    const UnicodeString* keyword;
+    while ((keyword = keywords->snext(errorCode)) != nullptr && U_SUCCESS(errorCode)) {
+        std::string name;
+        keyword->toUTF8String(name);
+        auto found = std::find(std::begin(categoryNames), std::end(categoryNames), name);
+        if (found == std::end(categoryNames)) {
+            return {};
+        }
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        categories.push_back("CATEGORY_" + name);
+        mask |= 1u << (found - std::begin(categoryNames));
+    }
+    if (U_FAILURE(errorCode)) {
+        return {};
+    }
+    return categories;
+}
+
+int main() {
+    UVersionInfo version;
+    u_getVersion(version);
+    std::string icuVersion = versionToString(version);
+    UErrorCode errorCode = U_ZERO_ERROR;
+    ulocdata_getCLDRVersion(version, &errorCode);
+    std::string cldrVersion = U_SUCCESS(errorCode) ? versionToString(version) : "unknown";
+
+    // The root locale is the empty string
+    std::map<std::string, std::vector<std::string>> localeCategoriesByName;
+    std::map<std::string, uint32_t> masks;
+    int32_t count;
+    const Locale* locales = Locale::getAvailableLocales(count);
+    std::vector<const char*> names = { "" };
+    for (int32_t i = 0; i < count; i++) {
+        names.push_back(locales[i].getName());
+    }
+    for (auto it = names.begin(); it != names.end(); ++it) {
+        uint32_t mask;
+        std::vector<std::string> categories = localeCategories(Locale(*it), mask);
+        if (categories.empty()) {
+            cerr << format("genpluraltables: couldn't get plural categories for locale \"{}\"\n", *it);
+            return 1;
+        }
+        localeCategoriesByName[*it] = categories;
+        masks[*it] = mask;
+    }
+
+    // Locales share a few distinct lists of categories
+    std::map<std::vector<std::string>, int> lists;
+    for (auto it = localeCategoriesByName.begin(); it != localeCategoriesByName.end(); ++it) {
+        lists.emplace(it->second, 0);
+    }
+    int listNumber = 0;
+    for (auto it = lists.begin(); it != lists.end(); ++it) {
+        it->second = listNumber++;
+    }
+
+    cout << format("// Generated by genpluraltables from ICU {} (CLDR {}); do not edit.\n\n", icuVersion, cldrVersion);
+    cout << "#pragma once\n\n#include \"pluralcategories.h\"\n\n";
+    for (auto it = lists.begin(); it != lists.end(); ++it) {
+        std::string items;
+        for (auto c = it->first.begin(); c != it->first.end(); ++c) {
+            items += format("{}{}", c == it->first.begin() ? "" : ", ", *c);
+        }
+        cout << format("static constexpr PluralCategory PLURAL_LIST_{}[] = {{ {} }};\n", it->second, items);
+    }
+    cout << "\n// Sorted by locale name\nstatic constexpr PluralTableEntry PLURAL_TABLE[] = {\n";
+    // std::map orders names the same way as std::string_view comparisons
+    for (auto it = localeCategoriesByName.begin(); it != localeCategoriesByName.end(); ++it) {
+        cout << format("    {{ \"{}\", {{ PLURAL_LIST_{}, 0x{:02x} }} }},\n", it->first, lists[it->second],
+                       masks[it->first]);
+    }
+    cout << "};\n";
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include <format>
+
+#include "json.h"
+
+using namespace std;
+
+std::string jsonString(std::string_view s) {
+    std::string quoted;
+    quoted.reserve(s.size() + 2);
+    quoted.push_back('"');
+    for (auto it = s.begin(); it != s.end(); ++it) {
+        unsigned char c = *it;
+        switch (c) {
+        case '"': quoted += "\\\""; break;
+        case '\\': quoted += "\\\\"; break;
+        case '\b': quoted += "\\b"; break;
+        case '\f': quoted += "\\f"; break;
+        case '\n': quoted += "\\n"; break;
+        case '\r': quoted += "\\r"; break;
+        case '\t': quoted += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                quoted += format("\\u{:04x}", c);
+            } else {
+                quoted.push_back(c);
+            }
+        }
+    }
+    quoted.push_back('"');
+    return quoted;
+}
@@ -0,0 +1,10 @@
+// Helpers for writing JSON output.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Returns `s` (UTF-8) as a quoted JSON string, escaping quotes,
+// backslashes and control characters
+std::string jsonString(std::string_view s);
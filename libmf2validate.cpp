@@ -0,0 +1,675 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+
+#include <unicode/ustring.h>
+#include <unicode/messageformat2.h>
+#include <unicode/messageformat2_data_model.h>
+
+#include "checks.h"
+#include "coverage.h"
+#include "libmf2validate.h"
+#include "messageview.h"
+#include "pluralcategories.h"
+#include "prescan.h"
+
+using namespace icu;
+using namespace message2;
+using namespace std;
+
+// Thrown when a check fails in a way that prevents any further checking;
+// caught in validateMessages(), which records the exit code in the result
+struct ValidationFailure {
+    int exitCode;
+};
+
+// Initial space for each arena that message views are allocated from; big
+// enough for most messages, which then need no heap allocations for the views
+// themselves
+static constexpr size_t ARENA_BUFFER_SIZE = 8192;
+// First block of each memoized analysis's arena; most messages' views fit in it
+static constexpr size_t MEMO_ARENA_INITIAL_SIZE = 1024;
+
+void log(ValidationResult& result, std::string s, int code = 0,
+         MessageRole role = ROLE_NONE, std::string variantKeys = "") {
+    result.diagnostics.push_back({ code, std::move(s), role, std::move(variantKeys) });
+}
+
+[[noreturn]] void fail(ValidationResult& result, int exitCode, std::string s,
+                       MessageRole role = ROLE_NONE, std::string variantKeys = "") {
+    log(result, std::move(s), exitCode, role, std::move(variantKeys));
+    throw ValidationFailure { exitCode };
+}
+
+// Adds the time between its construction and destruction to one of the phases
+// in `times`, unless `times` is null, in which case the clock is never read
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseTimes* times, ValidationPhase phase) : times(times), phase(phase) {
+        if (times) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~PhaseTimer() {
+        if (times) {
+            times->nanos[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+private:
+    PhaseTimes* times;
+    ValidationPhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+const char* phaseToString(ValidationPhase phase) {
+    switch (phase) {
+    case PHASE_PARSE:
+        return "parse";
+    case PHASE_DATA_MODEL:
+        return "dataModel";
+    case PHASE_PLURAL_COVERAGE:
+        return "pluralCoverage";
+    case PHASE_PLACEHOLDERS:
+        return "placeholders";
+    default:
+        return "";
+    }
+}
+
+const char* exitCodeToString(int exitCode) {
+    switch (exitCode) {
+    case 0:
+        return "OK";
+    case MISSING_PLURAL_CATEGORY:
+        return "MISSING_PLURAL_CATEGORY";
+    case PARSE_ERROR:
+        return "PARSE_ERROR";
+    case NOT_YET_IMPLEMENTED:
+        return "NOT_YET_IMPLEMENTED";
+    case DATA_MODEL_ERROR:
+        return "DATA_MODEL_ERROR";
+    case ICU_INTERNAL_ERROR:
+        return "ICU_INTERNAL_ERROR";
+    case NON_PLURAL_SELECTORS:
+        return "NON_PLURAL_SELECTORS";
+    case ASSERTION_FAILED:
+        return "ASSERTION_FAILED";
+    case IO_ERROR:
+        return "IO_ERROR";
+    case PARTIAL_WILDCARDS:
+        return "PARTIAL_WILDCARDS";
+    case INCONSISTENT_PLACEHOLDERS:
+        return "INCONSISTENT_PLACEHOLDERS";
+    case CATALOG_MISMATCH:
+        return "CATALOG_MISMATCH";
+    default:
+        return "OTHER";
+    }
+}
+
+std::string fromUStr(const UnicodeString& uStr) {
+    std::string str;
+    return uStr.toUTF8String(str);
+}
+
+std::string localeToString(const Locale& locale) {
+    UErrorCode status = U_ZERO_ERROR;
+    std::string result = locale.toLanguageTag<std::string>(status);
+    if (U_FAILURE(status)) {
+        return "[Bad locale]";
+    }
+    return result;
+}
+
+void checkICUError(ValidationResult& result, UErrorCode errorCode, std::string errorMessage) {
+    if (U_FAILURE(errorCode)) {
+        fail(result, ICU_INTERNAL_ERROR, errorMessage);
+    }
+}
+
+bool checkValidKeys(ValidationResult& result,
+                    const Locale& locale, MessageRole role, const MessageView& view,
+                    const LocalePluralCategories& pluralCategories) {
+    for (size_t i = 0; i < view.variants.size(); i++) {
+        const std::pmr::vector<PluralCategory>& keys = view.variants[i].keys;
+        for (size_t j = 0; j < keys.size(); j++) {
+            PluralCategory category = keys[j];
+            if (category == CATEGORY_WILDCARD) {
+                continue;
+            }
+            if (!pluralCategories.contains(category)) {
+                log(result, format("Key {} is not a valid plural category for locale {}.",
+                                   fromUStr(view.keyToString(i, j)), localeToString(locale)), MISSING_PLURAL_CATEGORY,
+                    role, view.keysToString(i));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool partialWildcards(std::span<const PluralCategory> keys) {
+    bool wildcardSeen = false;
+    bool nonWildcardSeen = false;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (*it == CATEGORY_WILDCARD) {
+            wildcardSeen = true;
+        } else {
+            nonWildcardSeen = true;
+        }
+    }
+    return wildcardSeen && nonWildcardSeen;
+}
+
+std::string categoriesToString(std::span<const PluralCategory> categories) {
+    std::string result;
+    bool first = true;
+
+    for (auto it = categories.begin(); it != categories.end(); ++it) {
+        if (!first) {
+            result += ' ';
+        }
+        first = false;
+        result += categoryToString(*it);
+    }
+    return result;
+}
+
+bool allOther(std::span<const PluralCategory> keys) {
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (*it != CATEGORY_OTHER) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool missingOtherVariant(const MessageView& view) {
+    for (auto it = view.variants.begin(); it != view.variants.end(); ++it) {
+        if (allOther(it->keys)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Marks the tuples covered by each variant, then reports the
+// tuples that no variant covers
+bool checkCoverage(ValidationResult& result, MessageRole role, const MessageView& view,
+                   CategoryCoverage& coverage, size_t numSelectors) {
+    for (auto it = view.variants.begin(); it != view.variants.end(); ++it) {
+        if (it->keys.size() != numSelectors) {
+            log(result, "Warning: variant has fewer keys than there are selectors", 0, role,
+                categoriesToString(it->keys));
+            return false;
+        }
+        if (it->allWildcards) {
+            continue;
+        }
+        // Keys that aren't categories for this locale are reported by checkValidKeys()
+        coverage.add(it->keys);
+    }
+    // Special case: it's OK to omit the 'other' variant if a '*'
+    // variant is present (which is checked separately.)
+    coverage.add(std::vector<PluralCategory>(numSelectors, CATEGORY_OTHER));
+
+    std::vector<std::vector<PluralCategory>> omitted;
+    coverage.uncovered(omitted);
+    for (auto it = omitted.begin(); it != omitted.end(); ++it) {
+        if (partialWildcards(*it)) {
+            log(result, format("Omitted variants: {} (where * is any plural category)", categoriesToString(*it)),
+                MISSING_PLURAL_CATEGORY, role, categoriesToString(*it));
+        } else {
+            log(result, format("Omitted variant: {}", categoriesToString(*it)), MISSING_PLURAL_CATEGORY,
+                role, categoriesToString(*it));
+        }
+    }
+    return omitted.empty();
+}
+
+// Checks for the data model errors that have to do with variants, by inspecting
+// the data model directly rather than formatting the message.
+// Other data model errors aren't reported.
+void checkDataModelErrors(ValidationResult& result, MessageRole role, const MessageView& view) {
+    if (view.selectors.empty()) {
+        return;
+    }
+
+    for (auto it = view.selectors.begin(); it != view.selectors.end(); ++it) {
+        if (!it->annotated) {
+            fail(result, DATA_MODEL_ERROR,
+                 "Data model error: A selector variable refers to an expression with no annotation.\n", role);
+        }
+    }
+
+    bool hasWildcardVariant = false;
+    for (size_t i = 0; i < view.variants.size(); i++) {
+        if (view.variants[i].keys.size() != view.selectors.size()) {
+            fail(result, DATA_MODEL_ERROR,
+                 "Data model error: One or more variants has a different number of keys from the number of selectors.\n",
+                 role, view.keysToString(i));
+        }
+        hasWildcardVariant |= view.variants[i].allWildcards;
+    }
+    if (!hasWildcardVariant) {
+        fail(result, DATA_MODEL_ERROR, "Data model error: Missing '*' variant.\n", role);
+    }
+}
+
+// Decodes the UTF-8 `message` into a buffer that is reused by later calls
+// on the same thread, so that once the buffer is big enough, decoding
+// doesn't allocate. Ill-formed UTF-8 is replaced with U+FFFD.
+const UnicodeString& decodeMessage(std::string_view message) {
+    thread_local UnicodeString buffer;
+    // A UTF-8 string never has fewer code units than its UTF-16 equivalent
+    int32_t capacity = message.size() + 1;
+    UChar* chars = buffer.getBuffer(capacity);
+    if (chars == nullptr) {
+        buffer = UnicodeString::fromUTF8(StringPiece(message.data(), message.size()));
+        return buffer;
+    }
+    int32_t length = 0;
+    UErrorCode errorCode = U_ZERO_ERROR;
+    u_strFromUTF8WithSub(chars, capacity, &length, message.data(), message.size(),
+                         0xFFFD, nullptr, &errorCode);
+    buffer.releaseBuffer(U_SUCCESS(errorCode) ? length : 0);
+    return buffer;
+}
+
+MFDataModel parseMessage(ValidationResult& result, const Locale& locale, MessageRole role,
+                         std::string_view message) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    UParseError parseError;
+
+    MessageFormatter::Builder builder(errorCode);
+    MessageFormatter mf = builder.setPattern(decodeMessage(message),
+                                             parseError, errorCode)
+        .setLocale(locale)
+        // Strict error handling, so that errors aren't silently recovered from
+        .setErrorHandlingBehavior(MessageFormatter::U_MF_STRICT)
+        .build(errorCode);
+
+    if (U_FAILURE(errorCode)) {
+        fail(result, PARSE_ERROR, format("Couldn't parse message {}", message), role);
+    }
+
+    return mf.getDataModel();
+}
+
+// Parses `message` and flattens its data model into a view allocated from `arena`
+MessageView getMessageView(ValidationResult& result, const Locale& locale, MessageRole role,
+                           std::string_view message, PhaseTimes* times, std::pmr::memory_resource* arena) {
+    std::optional<MessageView> view;
+    {
+        PhaseTimer timer(times, PHASE_PARSE);
+        // Simple messages would parse to an empty view, so ICU isn't needed for them
+        if (isSimpleMessage(message)) {
+            return MessageView(arena);
+        }
+        view.emplace(parseMessage(result, locale, role, message), arena);
+    }
+
+    PhaseTimer timer(times, PHASE_DATA_MODEL);
+    checkDataModelErrors(result, role, *view);
+
+    return std::move(*view);
+}
+
+bool checkPluralCategories(ValidationResult& result,
+                           const Locale& locale, bool isSource, const MessageView& view) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    MessageRole role = isSource ? ROLE_SOURCE : ROLE_TARGET;
+
+    size_t numSelectors = view.selectors.size();
+    if (numSelectors == 0) {
+        log(result, format("Warning: {} message is not made up of a .match construct. Trivially correct.",
+                           isSource ? "source" : "target"), 0, role);
+        return true;
+    }
+
+    // Get plural rules and categories for this locale (cached across messages)
+    const LocalePluralCategories* pluralCategories = getPluralCategories(locale, errorCode);
+    checkICUError(result, errorCode, format("Error getting plural rules for locale {}",
+                                            localeToString(locale)));
+
+    // Check that all selectors are plural; if any are non-plural, we can't check
+    // how many variants there should be
+    for (auto it = view.selectors.begin(); it != view.selectors.end(); ++it) {
+        if (!it->plural) {
+            fail(result, NON_PLURAL_SELECTORS, "Message uses non-plural selectors. Can't check exhaustiveness.\n",
+                 role);
+        }
+    }
+
+    // Partial wildcard variants (variants with multiple keys where some are wildcards
+    // and some aren't) each cover more than one tuple of categories
+    bool hasPartialWildcards = false;
+    for (auto it = view.variants.begin(); it != view.variants.end(); ++it) {
+        hasPartialWildcards |= it->partialWildcards;
+    }
+
+    bool allOK = true;
+    if (!hasPartialWildcards) {
+        // There is one tuple of plural categories for each combination of selector values
+        uint64_t expectedSize = CategoryCoverage::tupleCount(pluralCategories->categories.size(),
+                                                             numSelectors) + 1;
+        // It's OK if a variant all of whose keys are `other` is missing
+        if (missingOtherVariant(view)) {
+            expectedSize--;
+        }
+
+        // Check that the number of variants == the number of tuples plus 1
+        if (view.variants.size() != expectedSize) {
+            log(result, format("Incorrect number of variants; there are {} and should\
+ be {} including the wildcard variant.", view.variants.size(), expectedSize), MISSING_PLURAL_CATEGORY, role);
+            allOK = false;
+        }
+    }
+
+    // Check that each tuple has a corresponding variant
+    CategoryCoverage coverage(pluralCategories->categories, numSelectors);
+    allOK &= checkCoverage(result, role, view, coverage, numSelectors);
+
+    // Check for keys that aren't valid plural category names
+    allOK &= checkValidKeys(result, locale, role, view, *pluralCategories);
+    return allOK;
+}
+
+// Returns the placeholders that every variant of the source message uses,
+// and warns about any that only some variants use
+PlaceholderSet collectPlaceholders(ValidationResult& result, const MessageView& view,
+                                   std::pmr::memory_resource* arena) {
+    PlaceholderSet common(arena);
+    if (view.variants.empty()) {
+        return common;
+    }
+    common = view.variants[0].placeholders;
+    PlaceholderSet any(arena);
+    for (auto variant = view.variants.begin(); variant != view.variants.end(); ++variant) {
+        PlaceholderSet intersection(arena);
+        std::set_intersection(common.begin(), common.end(), variant->placeholders.begin(),
+                              variant->placeholders.end(), std::back_inserter(intersection));
+        common.swap(intersection);
+        PlaceholderSet merged(arena);
+        std::set_union(any.begin(), any.end(), variant->placeholders.begin(), variant->placeholders.end(),
+                       std::back_inserter(merged));
+        any.swap(merged);
+    }
+    for (auto it = any.begin(); it != any.end(); ++it) {
+        if (!std::binary_search(common.begin(), common.end(), *it)) {
+            log(result, format("Warning: not all variants in source message\
+ contain the same set of placeholders. The placeholder ${} does not appear in\
+ every variant.",
+                               fromUStr(*it)), 0, ROLE_SOURCE);
+        }
+    }
+    return common;
+}
+
+bool checkPlaceholders(ValidationResult& result, const PlaceholderSet& sourcePlaceholders,
+                       const MessageView& targetView, std::pmr::memory_resource* arena) {
+    bool ok = true;
+    for (size_t i = 0; i < targetView.variants.size(); i++) {
+        const PlaceholderSet& targetPlaceholders = targetView.variants[i].placeholders;
+        PlaceholderSet missing(arena);
+        std::set_difference(sourcePlaceholders.begin(), sourcePlaceholders.end(),
+                            targetPlaceholders.begin(), targetPlaceholders.end(),
+                            std::back_inserter(missing));
+        for (auto it = missing.begin(); it != missing.end(); ++it) {
+            std::string keys = targetView.keysToString(i);
+            log(result, format("In target message, variant with keys «{}» omits placeholder: ${}",
+                               keys, fromUStr(*it)),
+                INCONSISTENT_PLACEHOLDERS, ROLE_TARGET, keys);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void reportResults(ValidationResult& result,
+                   const Locale& sourceLocale, const Locale& targetLocale,
+                   bool sourceOK, bool targetOK, bool placeholdersOK) {
+    log(result, format("Source locale: {}",
+               localeToString(sourceLocale)));
+
+    if (sourceOK) {
+        log(result, "Source message covers all plural categories.");
+    } else {
+        log(result, "Source message does not cover all plural categories, or has extraneous categories.");
+    }
+
+    log(result, format("Target locale: {}",
+               localeToString(targetLocale)));
+
+    if (targetOK) {
+        log(result, "Target message covers all plural categories.");
+    } else {
+        log(result, "Target message does not cover all plural categories, or has extraneous categories.");
+    }
+
+    if (placeholdersOK) {
+        log(result, "All variants in target message include placeholders from source message.");
+    } else {
+        log(result, "One or more variants in target message omit placeholders from target message.");
+    }
+}
+
+// Everything about one message, in one role, that doesn't depend on the other
+// message: shared through the memo below by every copy of the same message
+struct MessageAnalysis {
+    MessageAnalysis(const Locale& locale, std::string_view message)
+        : locale(locale), message(message), arena(MEMO_ARENA_INITIAL_SIZE) {}
+
+    Locale locale;
+    std::string message;
+    // The view and the placeholders are allocated from this. It isn't given an
+    // inline buffer, since the memo holds many analyses at once.
+    std::pmr::monotonic_buffer_resource arena;
+    // Diagnostics from parsing the message, with the exit code if it failed
+    ValidationResult parse;
+    // Set if parsing succeeded
+    std::optional<MessageView> view;
+    // Diagnostics from checkPluralCategories(), with the exit code if it failed
+    ValidationResult checks;
+    bool checksOK = false;
+    // For source messages, warnings from collectPlaceholders(), and the
+    // placeholders that every variant uses
+    ValidationResult placeholderWarnings;
+    PlaceholderSet placeholders { &arena };
+};
+
+static void analyze(MessageAnalysis& analysis, MessageRole role, PhaseTimes* times) {
+    try {
+        analysis.view.emplace(getMessageView(analysis.parse, analysis.locale, role, analysis.message, times,
+                                             &analysis.arena));
+    } catch (const ValidationFailure& failure) {
+        analysis.parse.status = failure.exitCode;
+        return;
+    }
+    {
+        PhaseTimer timer(times, PHASE_PLURAL_COVERAGE);
+        try {
+            analysis.checksOK = checkPluralCategories(analysis.checks, analysis.locale, role == ROLE_SOURCE,
+                                                      *analysis.view);
+        } catch (const ValidationFailure& failure) {
+            analysis.checks.status = failure.exitCode;
+        }
+    }
+    if (role == ROLE_SOURCE) {
+        PhaseTimer timer(times, PHASE_PLACEHOLDERS);
+        analysis.placeholders = collectPlaceholders(analysis.placeholderWarnings, *analysis.view, &analysis.arena);
+    }
+}
+
+// Recently analyzed messages, by role, locale and text, so that copies of a
+// message, such as repeated plural patterns and untranslated fallbacks, are
+// only parsed and checked once. The memo is split into shards, each with its
+// own lock, and each shard holds two generations of entries: when the newer
+// one fills up, the older one is dropped, so memory use is bounded and the
+// messages that keep recurring stay in the memo.
+class MessageMemo {
+public:
+    std::shared_ptr<const MessageAnalysis> find(const std::string& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.current.find(key);
+        if (it != shard.current.end()) {
+            return it->second;
+        }
+        it = shard.previous.find(key);
+        if (it == shard.previous.end()) {
+            return nullptr;
+        }
+        // Still in use, so it moves up to the newer generation
+        std::shared_ptr<const MessageAnalysis> analysis = it->second;
+        insert(shard, key, analysis);
+        return analysis;
+    }
+
+    void insert(const std::string& key, std::shared_ptr<const MessageAnalysis> analysis) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        insert(shard, key, std::move(analysis));
+    }
+
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+    static constexpr size_t GENERATION_SIZE = 256;
+
+    using Generation = std::unordered_map<std::string, std::shared_ptr<const MessageAnalysis>>;
+
+    struct Shard {
+        std::mutex mutex;
+        Generation current;
+        Generation previous;
+    };
+
+    Shard& shardFor(const std::string& key) {
+        return shards[std::hash<std::string>()(key) % NUM_SHARDS];
+    }
+
+    static void insert(Shard& shard, const std::string& key, std::shared_ptr<const MessageAnalysis> analysis) {
+        if (shard.current.size() >= GENERATION_SIZE) {
+            // Analyses still in use elsewhere live on through their shared_ptrs
+            shard.previous.swap(shard.current);
+            shard.current.clear();
+        }
+        shard.current.insert_or_assign(key, std::move(analysis));
+    }
+
+    Shard shards[NUM_SHARDS];
+};
+
+static MessageMemo messageMemo;
+static std::atomic<uint64_t> memoLookups = 0;
+static std::atomic<uint64_t> memoHits = 0;
+
+MessageMemoStats messageMemoStats() {
+    return { memoLookups.load(), memoHits.load() };
+}
+
+// Returns the analysis of `message` in `role`, from the memo if the same
+// message has been analyzed in the same role and locale recently. Phases
+// are only timed if the message is analyzed.
+static std::shared_ptr<const MessageAnalysis> analyzeMessage(const Locale& locale, MessageRole role,
+                                                             std::string_view message, PhaseTimes* times) {
+    // Locale names can't contain NUL, so the key is unambiguous
+    std::string key = format("{}{}", static_cast<char>('0' + role), locale.getName());
+    key += '\0';
+    key += message;
+    memoLookups.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<const MessageAnalysis> analysis = messageMemo.find(key);
+    if (analysis) {
+        memoHits.fetch_add(1, std::memory_order_relaxed);
+        return analysis;
+    }
+    auto fresh = std::make_shared<MessageAnalysis>(locale, message);
+    analyze(*fresh, role, times);
+    messageMemo.insert(key, fresh);
+    return fresh;
+}
+
+SourceAnalysis::SourceAnalysis(const Locale& locale, std::string_view message, PhaseTimes* times)
+    : analysis(analyzeMessage(locale, ROLE_SOURCE, message, times)) {}
+
+SourceAnalysis::~SourceAnalysis() = default;
+
+const Locale& SourceAnalysis::locale() const {
+    return analysis->locale;
+}
+
+std::string_view SourceAnalysis::message() const {
+    return analysis->message;
+}
+
+static void append(ValidationResult& result, const ValidationResult& diagnostics) {
+    result.diagnostics.insert(result.diagnostics.end(), diagnostics.diagnostics.begin(),
+                              diagnostics.diagnostics.end());
+}
+
+// The diagnostics come out in the same order as if both messages were checked
+// together: parsing both, then the plural checks of each, then placeholders
+ValidationResult SourceAnalysis::validate(const Locale& targetLocale, std::string_view targetMessage,
+                                          PhaseTimes* times) const {
+    const MessageAnalysis& source = *analysis;
+    ValidationResult result = source.parse;
+    if (result.status != 0) {
+        return result;
+    }
+    std::shared_ptr<const MessageAnalysis> target = analyzeMessage(targetLocale, ROLE_TARGET, targetMessage, times);
+    try {
+        append(result, target->parse);
+        if (target->parse.status != 0) {
+            throw ValidationFailure { target->parse.status };
+        }
+
+        log(result, "== Checking source message ==");
+        append(result, source.checks);
+        if (source.checks.status != 0) {
+            throw ValidationFailure { source.checks.status };
+        }
+        log(result, "== Checking target message ==");
+        append(result, target->checks);
+        if (target->checks.status != 0) {
+            throw ValidationFailure { target->checks.status };
+        }
+
+        bool placeholdersOK;
+        {
+            PhaseTimer timer(times, PHASE_PLACEHOLDERS);
+            log(result, "== Checking placeholder consistency ==");
+            append(result, source.placeholderWarnings);
+            // Everything checkPlaceholders() allocates comes from this arena, which
+            // starts out on the stack and is freed all at once on return
+            std::byte arenaBuffer[ARENA_BUFFER_SIZE];
+            std::pmr::monotonic_buffer_resource arena(arenaBuffer, sizeof(arenaBuffer));
+            placeholdersOK = checkPlaceholders(result, source.placeholders, *target->view, &arena);
+        }
+
+        log(result, "== Results ==");
+        reportResults(result, source.locale, targetLocale, source.checksOK, target->checksOK, placeholdersOK);
+
+        result.status = (source.checksOK && target->checksOK && placeholdersOK) ? 0
+            : !placeholdersOK ? INCONSISTENT_PLACEHOLDERS
+            : MISSING_PLURAL_CATEGORY;
+    } catch (const ValidationFailure& failure) {
+        result.status = failure.exitCode;
+    }
+    return result;
+}
+
+ValidationResult validateMessages(const Locale& sourceLocale, const Locale& targetLocale,
+                                  std::string_view sourceMessage, std::string_view targetMessage,
+                                  PhaseTimes* times) {
+    return SourceAnalysis(sourceLocale, sourceMessage, times).validate(targetLocale, targetMessage, times);
+}
@@ -0,0 +1,146 @@
+// Library interface to the MF2 validator.
+//
+// All functions are reentrant: nothing is written to stdout, and a failing
+// check never exits the process. Instead, each call returns a
+// ValidationResult with an exit code and the list of diagnostics produced
+// along the way.
+//
+// The only state kept between calls is two caches, with their hit counters:
+// the per-locale cache of plural categories (see pluralcategories.h), and the
+// memo of recently analyzed messages (see messageMemoStats()). Both live for
+// the whole process, are safe to use from several threads at once, hold a
+// bounded number of entries, and never change a result: a call returns the
+// same ValidationResult whether or not the caches already hold its locales
+// and messages.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unicode/locid.h>
+
+// Increment whenever a change to the checks could change a ValidationResult,
+// so that results cached by earlier versions aren't reused
+#define VALIDATOR_VERSION 4
+
+#define MISSING_PLURAL_CATEGORY 1
+#define PARSE_ERROR 2
+#define NOT_YET_IMPLEMENTED 3
+#define DATA_MODEL_ERROR 4
+#define ICU_INTERNAL_ERROR 5
+#define NON_PLURAL_SELECTORS 6
+#define ASSERTION_FAILED 7
+#define IO_ERROR 8
+// No longer produced: partial wildcard variants are now checked for coverage
+#define PARTIAL_WILDCARDS 9
+#define INCONSISTENT_PLACEHOLDERS 10
+// A message ID is in only one of the source and target catalogs
+#define CATALOG_MISMATCH 11
+
+// Which of the two messages a diagnostic is about
+enum MessageRole {
+    ROLE_NONE,
+    ROLE_SOURCE,
+    ROLE_TARGET
+};
+
+struct Diagnostic {
+    // One of the exit codes above if this diagnostic explains a failure;
+    // 0 for progress messages and warnings
+    int code;
+    std::string message;
+    // ROLE_NONE if the diagnostic isn't about just one of the messages
+    MessageRole role = ROLE_NONE;
+    // The keys of the variant the diagnostic is about, separated by spaces;
+    // empty if it isn't about a single variant
+    std::string variantKeys;
+};
+
+struct ValidationResult {
+    // 0 if the target message is a valid translation of the source message;
+    // otherwise one of the exit codes above
+    int status = 0;
+    // In the order they were produced
+    std::vector<Diagnostic> diagnostics;
+};
+
+// The phases of validateMessages(), each covering both messages
+enum ValidationPhase {
+    // Building the data model
+    PHASE_PARSE,
+    // Checking the data model for variant-related errors
+    PHASE_DATA_MODEL,
+    // Checking that the variants cover the plural categories
+    PHASE_PLURAL_COVERAGE,
+    // Checking that the target message uses the source message's placeholders
+    PHASE_PLACEHOLDERS,
+    NUM_PHASES
+};
+
+const char* phaseToString(ValidationPhase phase);
+
+struct PhaseTimes {
+    // Nanoseconds spent in each phase; 0 for phases that weren't reached
+    uint64_t nanos[NUM_PHASES] = {};
+};
+
+// Returns the name of the #define for `exitCode` (such as "PARSE_ERROR"),
+// "OK" for 0, or "OTHER" if there is no such exit code
+const char* exitCodeToString(int exitCode);
+
+std::string localeToString(const icu::Locale& locale);
+
+// Checks the source and target messages (encoded in UTF-8) for plural category coverage,
+// and checks that the target message uses the placeholders from the source message.
+// If `times` isn't null, the time spent in each phase is added to it.
+ValidationResult validateMessages(const icu::Locale& sourceLocale, const icu::Locale& targetLocale,
+                                  std::string_view sourceMessage, std::string_view targetMessage,
+                                  PhaseTimes* times = nullptr);
+
+struct MessageAnalysis;
+
+// A source message that has been parsed and checked once, so that it can be
+// validated against many target messages without checking it again.
+// Read-only once constructed, so validate() can be called from multiple threads at once.
+//
+// The analyses of source and target messages are memoized by locale and text,
+// so copies of a message (here or in validateMessages()) are only parsed and
+// checked once while they keep recurring.
+class SourceAnalysis {
+public:
+    // If `times` isn't null, the time spent on the source message is added to it
+    SourceAnalysis(const icu::Locale& locale, std::string_view message, PhaseTimes* times = nullptr);
+    ~SourceAnalysis();
+
+    const icu::Locale& locale() const;
+    std::string_view message() const;
+
+    // Returns the same result as
+    // validateMessages(locale(), targetLocale, message(), targetMessage)
+    ValidationResult validate(const icu::Locale& targetLocale, std::string_view targetMessage,
+                              PhaseTimes* times = nullptr) const;
+
+private:
+    std::shared_ptr<const MessageAnalysis> analysis;
+};
+
+struct PluralCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+};
+
+// Counts of lookups in the per-locale plural rules cache since the process started
+PluralCacheStats pluralCacheStats();
+
+struct MessageMemoStats {
+    uint64_t lookups;
+    // Lookups of a message that had already been analyzed, in the same role and locale
+    uint64_t hits;
+};
+
+// Counts of lookups in the memo of message analyses since the process started
+MessageMemoStats messageMemoStats();
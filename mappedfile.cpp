@@ -0,0 +1,60 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mappedfile.h"
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingLength);
+        mapping = nullptr;
+        mappingLength = 0;
+    }
+    buffer.clear();
+    view = std::string_view();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    // Empty files can't be mapped
+    if (S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::close(fd);
+            // Files are read from start to end, so the kernel can read ahead
+            // and drop pages that have been read
+            madvise(address, info.st_size, MADV_SEQUENTIAL);
+            mapping = address;
+            mappingLength = info.st_size;
+            view = std::string_view(static_cast<const char*>(mapping), mappingLength);
+            return true;
+        }
+    }
+
+    char chunk[65536];
+    ssize_t count;
+    while ((count = read(fd, chunk, sizeof(chunk))) > 0) {
+        buffer.append(chunk, count);
+    }
+    ::close(fd);
+    if (count < 0) {
+        buffer.clear();
+        return false;
+    }
+    view = buffer;
+    return true;
+}
@@ -0,0 +1,31 @@
+// Read-only access to a file's contents without copying them.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Regular files are memory-mapped; other files (pipes, for example)
+// are read into memory instead
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file can't be opened or read
+    bool open(const std::string& filename);
+
+    // Valid until the MappedFile is destroyed or reopened
+    std::string_view contents() const { return view; }
+
+private:
+    void close();
+
+    void* mapping = nullptr;
+    size_t mappingLength = 0;
+    std::string buffer;
+    std::string_view view;
+};
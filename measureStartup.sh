@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Prints the startup cost of each mf2validate binary given as an argument:
+# its size, the mean wall-clock time of a run that validates one small pair
+# of messages (so nearly all of the time is startup), and that run's peak RSS
+# as reported by --stats. Set RUNS to change the number of runs per binary.
+#
+# The first run of each binary is discarded, so the times are for a warm page
+# cache; for a truly cold start, drop the page cache (as root) between runs.
+
+RUNS=${RUNS:-50}
+ARGS="--sourceLocale=en-US --targetLocale=cs-CZ --sourceFilename=test/English_message_good --targetFilename=test/Czech_message_good"
+
+printf "%-24s %12s %10s %14s\n" "binary" "bytes" "ms/run" "peak RSS (KB)"
+for binary in "$@"; do
+    if ! $binary $ARGS > /dev/null; then
+        echo "$binary failed"
+        exit 1
+    fi
+    start=$(date +%s%N)
+    for ((i = 0; i < RUNS; i++)); do
+        $binary $ARGS > /dev/null
+    done
+    end=$(date +%s%N)
+    peak=$($binary $ARGS --stats=- | grep -o '"peakMemoryBytes":[0-9]*' | cut -d: -f2)
+    printf "%-24s %12d %10.2f %14d\n" "$binary" "$(stat -c %s "$binary")" \
+        "$(awk "BEGIN { print ($end - $start) / $RUNS / 1000000 }")" "$((peak / 1024))"
+done
@@ -0,0 +1,159 @@
+#include <algorithm>
+
+#include "messageview.h"
+
+using namespace icu;
+using namespace message2;
+using namespace std;
+
+static void sortPlaceholders(PlaceholderSet& placeholders) {
+    std::sort(placeholders.begin(), placeholders.end());
+    placeholders.erase(std::unique(placeholders.begin(), placeholders.end()), placeholders.end());
+}
+
+static bool isNumberFunction(const Operator& rator) {
+    static const UnicodeString number("number");
+    return rator.getFunctionName() == number;
+}
+
+MessageView::MessageView(const MFDataModel& dataModel, std::pmr::memory_resource* arena)
+    : selectors(arena), declarations(arena), variants(arena), arena(arena) {
+    // Declarations can only refer to earlier ones, so one pass in order
+    // resolves every alias and rules out cycles
+    std::vector<Binding> decls = dataModel.getLocalVariables();
+    for (auto it = decls.begin(); it != decls.end(); ++it) {
+        declare(*it);
+    }
+
+    std::vector<VariableName> selectorNames = dataModel.getSelectors();
+    selectors.reserve(selectorNames.size());
+    for (auto it = selectorNames.begin(); it != selectorNames.end(); ++it) {
+        auto decl = declarations.find(*it);
+        // Unbound selectors have no annotation
+        if (decl == declarations.end()) {
+            selectors.push_back({ *it, false, false });
+        } else {
+            selectors.push_back({ *it, decl->second.annotated, decl->second.plural });
+        }
+    }
+
+    dataModelVariants = dataModel.getVariants();
+    variants.reserve(dataModelVariants.size());
+    for (auto variant = dataModelVariants.begin(); variant != dataModelVariants.end(); ++variant) {
+        VariantInfo info { std::pmr::vector<PluralCategory>(arena), false, false, PlaceholderSet(arena) };
+        const std::vector<Key> keys = variant->getKeys().getKeys();
+        info.keys.reserve(keys.size());
+        bool wildcardSeen = false;
+        bool nonWildcardSeen = false;
+        for (auto k = keys.begin(); k != keys.end(); ++k) {
+            if (k->isWildcard()) {
+                info.keys.push_back(CATEGORY_WILDCARD);
+                wildcardSeen = true;
+            } else {
+                info.keys.push_back(categoryFromString(k->asLiteral().unquoted()));
+                nonWildcardSeen = true;
+            }
+        }
+        info.allWildcards = !nonWildcardSeen;
+        info.partialWildcards = wildcardSeen && nonWildcardSeen;
+
+        const Pattern& pat = variant->getPattern();
+        for (auto patternPart = pat.begin(); patternPart != pat.end(); ++patternPart) {
+            if (std::holds_alternative<Expression>(*patternPart)) {
+                addExpression(std::get<Expression>(*patternPart), info.placeholders);
+            } else if (std::holds_alternative<Markup>(*patternPart)) {
+                addOptions(std::get<Markup>(*patternPart).getOptions(), info.placeholders);
+            }
+        }
+        sortPlaceholders(info.placeholders);
+        variants.push_back(std::move(info));
+    }
+}
+
+MessageView::MessageView(std::pmr::memory_resource* arena)
+    : selectors(arena), declarations(arena), variants(arena), arena(arena) {}
+
+void MessageView::declare(const Binding& decl) {
+    DeclarationInfo info { false, false, decl.isLocal(), PlaceholderSet(arena) };
+    const Expression& rhs = decl.getValue();
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const Operator* rator = rhs.getOperator(errorCode);
+    if (U_SUCCESS(errorCode)) {
+        info.annotated = true;
+        info.plural = isNumberFunction(*rator);
+    } else if (rhs.getOperand().isVariable()) {
+        // An alias has the annotation of the variable it refers to
+        auto aliased = declarations.find(rhs.getOperand().asVariable());
+        if (aliased != declarations.end()) {
+            info.annotated = aliased->second.annotated;
+            info.plural = aliased->second.plural;
+        }
+    }
+    if (info.local) {
+        addExpression(rhs, info.placeholders);
+        sortPlaceholders(info.placeholders);
+    } else if (info.annotated && U_SUCCESS(errorCode)) {
+        // The variables in the annotation's options, such as `$y` in
+        // `.input {$x :number minimumFractionDigits=$y}`, go wherever `$x` is used
+        addOptions(rator->getOptions(), info.placeholders);
+        sortPlaceholders(info.placeholders);
+    }
+    // Not assignment, which would copy the placeholders out of the arena
+    declarations.erase(decl.getVariable());
+    declarations.emplace(decl.getVariable(), std::move(info));
+}
+
+// Adds the external variables that `operand` refers to, directly or through
+// a declaration
+void MessageView::addOperand(const Operand& operand, PlaceholderSet& placeholders) const {
+    if (!operand.isVariable()) {
+        return;
+    }
+    const VariableName& variable = operand.asVariable();
+    auto decl = declarations.find(variable);
+    if (decl == declarations.end() || !decl->second.local) {
+        placeholders.push_back(variable);
+    }
+    if (decl != declarations.end()) {
+        placeholders.insert(placeholders.end(), decl->second.placeholders.begin(), decl->second.placeholders.end());
+    }
+}
+
+void MessageView::addOptions(const std::vector<Option>& options, PlaceholderSet& placeholders) const {
+    for (auto it = options.begin(); it != options.end(); ++it) {
+        addOperand(it->getValue(), placeholders);
+    }
+}
+
+void MessageView::addExpression(const Expression& expr, PlaceholderSet& placeholders) const {
+    addOperand(expr.getOperand(), placeholders);
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const Operator* rator = expr.getOperator(errorCode);
+    if (U_SUCCESS(errorCode)) {
+        addOptions(rator->getOptions(), placeholders);
+    }
+}
+
+// A wildcard key has no literal, so it is shown as `*`
+static UnicodeString keyText(const Key& key) {
+    if (key.isWildcard()) {
+        return UnicodeString(categoryToString(CATEGORY_WILDCARD), -1, US_INV);
+    }
+    return key.asLiteral().unquoted();
+}
+
+UnicodeString MessageView::keyToString(size_t i, size_t j) const {
+    return keyText(dataModelVariants[i].getKeys().getKeys()[j]);
+}
+
+std::string MessageView::keysToString(size_t i) const {
+    const std::vector<Key> keys = dataModelVariants[i].getKeys().getKeys();
+    std::string result;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (it != keys.begin()) {
+            result += ' ';
+        }
+        keyText(*it).toUTF8String(result);
+    }
+    return result;
+}
@@ -0,0 +1,83 @@
+// A read-only, flattened view of a message's data model, built in one pass
+// over the MFDataModel so that the checks don't each copy the selectors,
+// declarations and variants back out of it.
+//
+// Variant keys are interned as PluralCategory values and each variant's
+// placeholders are worked out up front. Everything the view allocates comes
+// from the memory resource passed to its constructor, which is meant to be
+// an arena that lives for one call to validateMessages() and is freed all at
+// once, so the view must not outlive it.
+
+#pragma once
+
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <unicode/messageformat2_data_model.h>
+#include <unicode/unistr.h>
+
+#include "pluralcategories.h"
+
+// A set of variable names, kept sorted and without duplicates
+using PlaceholderSet = std::pmr::vector<icu::UnicodeString>;
+
+// What the checks need to know about a variable bound by `.input` or `.local`
+struct DeclarationInfo {
+    // True if the right-hand side is annotated, either directly or through
+    // a chain of aliases like `.local $x = {$y}`
+    bool annotated;
+    // True if that annotation is `:number`
+    bool plural;
+    // True if bound by `.local` rather than `.input`
+    bool local;
+    // The external variables that the right-hand side uses, besides the
+    // declared variable itself: for `.input`, those in the annotation's options
+    PlaceholderSet placeholders;
+};
+
+struct SelectorInfo {
+    icu::UnicodeString name;
+    // False if the selector isn't declared, or is declared without an annotation
+    bool annotated;
+    bool plural;
+};
+
+struct VariantInfo {
+    // One entry per key: a category, CATEGORY_WILDCARD, or CATEGORY_NONE
+    // for a key that isn't a category name
+    std::pmr::vector<PluralCategory> keys;
+    bool allWildcards;
+    bool partialWildcards;
+    // The external variables that this variant uses
+    PlaceholderSet placeholders;
+};
+
+class MessageView {
+public:
+    MessageView(const icu::message2::MFDataModel& dataModel, std::pmr::memory_resource* arena);
+    // The view of a message with no declarations and no `.match`, which has no
+    // selectors and no variants
+    explicit MessageView(std::pmr::memory_resource* arena);
+
+    // The text of variant `i`'s keys, separated by spaces, for diagnostics
+    std::string keysToString(size_t i) const;
+    // The text of key `j` of variant `i`
+    icu::UnicodeString keyToString(size_t i, size_t j) const;
+
+    std::pmr::vector<SelectorInfo> selectors;
+    std::pmr::map<icu::UnicodeString, DeclarationInfo> declarations;
+    std::pmr::vector<VariantInfo> variants;
+
+private:
+    void addOperand(const icu::message2::Operand& operand, PlaceholderSet& placeholders) const;
+    void addOptions(const std::vector<icu::message2::Option>& options, PlaceholderSet& placeholders) const;
+    void addExpression(const icu::message2::Expression& expr, PlaceholderSet& placeholders) const;
+    void declare(const icu::message2::Binding& decl);
+
+    std::pmr::memory_resource* arena;
+    // The variants themselves, copied out of the data model once, for
+    // the text of their keys
+    std::vector<icu::message2::Variant> dataModelVariants;
+};
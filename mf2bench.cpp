@@ -0,0 +1,368 @@
+// Benchmarks validateMessages() on generated messages.
+//
+// For each combination of target locale and number of selectors, generates
+// pairs of `.match` messages (the source message is always in English) and
+// validates them, printing one line of JSON per combination with the
+// throughput, the allocations per message and the time spent in each phase.
+//
+// With --compareDataModelCheck, it instead times the data model check on the
+// same messages two ways: checkDataModelErrors() on the MessageView, and the
+// check it replaced, which formatted each message with no arguments and
+// looked at the error code.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <map>
+#include <memory_resource>
+
+#include <cxxopts.hpp>
+
+#include <unicode/messageformat2.h>
+#include <unicode/uclean.h>
+#include <unicode/uversion.h>
+
+#include "checks.h"
+#include "libmf2validate.h"
+#include "messageview.h"
+#include "pluralcategories.h"
+
+using namespace icu;
+using namespace icu::message2;
+using namespace std;
+
+// Counts allocations made by both the C++ runtime and ICU
+static std::atomic<uint64_t> allocations;
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+static void* U_CALLCONV icuAlloc(const void*, size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+static void* U_CALLCONV icuRealloc(const void*, void* p, size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(p, size);
+}
+
+static void U_CALLCONV icuFree(const void*, void* p) {
+    std::free(p);
+}
+
+struct BenchConfig {
+    std::string targetLocale;
+    int selectors;
+    // 0 means one variant per tuple of plural categories
+    int maxVariants;
+    int placeholders;
+    // Approximate number of bytes of text in each variant
+    int variantSize;
+    int messages;
+};
+
+// Text that varies from message to message, so that no two generated messages are the same
+static std::string fillerText(int size, int messageIndex) {
+    static const std::string words = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod ";
+    std::string text = std::to_string(messageIndex) + " ";
+    while (static_cast<int>(text.size()) < size) {
+        text += words.substr(0, std::min(words.size(), size - text.size()));
+    }
+    return text;
+}
+
+// The number of variants in a generated message, not counting the `*` variant
+static uint64_t numTuples(size_t numCategories, const BenchConfig& config) {
+    uint64_t tuples = 1;
+    for (int i = 0; i < config.selectors; i++) {
+        tuples *= numCategories;
+    }
+    if (config.maxVariants > 0 && tuples > static_cast<uint64_t>(config.maxVariants)) {
+        tuples = config.maxVariants;
+    }
+    return tuples;
+}
+
+// Generates a message with one variant per tuple of `categories`
+// (up to `maxVariants`), plus a `*` variant, or with 0 selectors, a message
+// without `.match`
+static std::string generateMessage(std::span<const PluralCategory> categories,
+                                   const BenchConfig& config, int messageIndex) {
+    std::string message;
+    if (config.selectors == 0) {
+        // A message without `.match`
+        message = fillerText(config.variantSize, messageIndex);
+        for (int i = 0; i < config.placeholders; i++) {
+            message += format(" {{$arg{}}}", i);
+        }
+        return message;
+    }
+    for (int i = 0; i < config.selectors; i++) {
+        message += format(".input {{$count{} :number}}\n", i);
+    }
+    message += ".match";
+    for (int i = 0; i < config.selectors; i++) {
+        message += format(" $count{}", i);
+    }
+    message += "\n";
+
+    std::string pattern = fillerText(config.variantSize, messageIndex);
+    for (int i = 0; i < config.selectors; i++) {
+        pattern += format(" {{$count{}}}", i);
+    }
+    for (int i = 0; i < config.placeholders; i++) {
+        pattern += format(" {{$arg{}}}", i);
+    }
+
+    uint64_t tuples = numTuples(categories.size(), config);
+    for (uint64_t tuple = 0; tuple < tuples; tuple++) {
+        uint64_t rest = tuple;
+        for (int i = 0; i < config.selectors; i++) {
+            message += categoryToString(categories[rest % categories.size()]);
+            message += " ";
+            rest /= categories.size();
+        }
+        message += format("{{{{{}}}}}\n", pattern);
+    }
+    for (int i = 0; i < config.selectors; i++) {
+        message += "* ";
+    }
+    message += format("{{{{{}}}}}\n", pattern);
+    return message;
+}
+
+static std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > start) {
+            items.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return items;
+}
+
+// Prints one line of JSON. Returns false if the messages couldn't be generated
+static bool runBench(const BenchConfig& config, const std::string& icuVersion) {
+    Locale sourceLocale("en");
+    Locale targetLocale(config.targetLocale.c_str());
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const LocalePluralCategories* sourceCategories = getPluralCategories(sourceLocale, errorCode);
+    const LocalePluralCategories* targetCategories = getPluralCategories(targetLocale, errorCode);
+    if (U_FAILURE(errorCode)) {
+        cerr << format("Error getting plural rules for locale {}\n", config.targetLocale);
+        return false;
+    }
+
+    std::vector<std::string> sources;
+    std::vector<std::string> targets;
+    uint64_t bytes = 0;
+    for (int i = 0; i < config.messages; i++) {
+        sources.push_back(generateMessage(sourceCategories->categories, config, i));
+        targets.push_back(generateMessage(targetCategories->categories, config, i));
+        bytes += sources.back().size() + targets.back().size();
+    }
+
+    // Warm up, so that plural rules and thread-local buffers aren't counted
+    validateMessages(sourceLocale, targetLocale, sources[0], targets[0]);
+
+    PhaseTimes times;
+    int failures = 0;
+    uint64_t allocationsBefore = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.messages; i++) {
+        ValidationResult result = validateMessages(sourceLocale, targetLocale, sources[i], targets[i], &times);
+        if (result.status != 0) {
+            failures++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t messageAllocations = allocations.load() - allocationsBefore;
+
+    std::string phases;
+    for (int phase = 0; phase < NUM_PHASES; phase++) {
+        phases += format("{}\"{}\":{:.0f}", phase == 0 ? "" : ",", phaseToString(static_cast<ValidationPhase>(phase)),
+                         static_cast<double>(times.nanos[phase]) / config.messages);
+    }
+    cout << format("{{\"icuVersion\":\"{}\",\"sourceLocale\":\"en\",\"targetLocale\":\"{}\",\"selectors\":{},"
+                   "\"targetVariants\":{},\"placeholders\":{},\"bytesPerMessage\":{},\"messages\":{},\"failures\":{},"
+                   "\"messagesPerSec\":{:.1f},\"allocationsPerMessage\":{:.1f},\"phaseNanosPerMessage\":{{{}}}}}\n",
+                   icuVersion, config.targetLocale, config.selectors,
+                   config.selectors == 0 ? 1 : numTuples(targetCategories->categories.size(), config) + 1,
+                   config.placeholders,
+                   bytes / (2 * config.messages), config.messages, failures,
+                   config.messages / seconds, static_cast<double>(messageAllocations) / config.messages, phases);
+    return true;
+}
+
+// The data model check as it was before checkDataModelErrors() inspected the
+// MessageView: data model errors are only reported when formatting, so the
+// message is formatted with no arguments. Returns DATA_MODEL_ERROR or 0.
+static int formattingDataModelCheck(MessageFormatter& mf) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    std::map<UnicodeString, message2::Formattable> empty;
+    MessageArguments args(empty, errorCode);
+    mf.formatToString(args, errorCode);
+    switch (errorCode) {
+    case U_MF_VARIANT_KEY_MISMATCH_ERROR:
+    case U_MF_NONEXHAUSTIVE_PATTERN_ERROR:
+    case U_MF_MISSING_SELECTOR_ANNOTATION_ERROR:
+        return DATA_MODEL_ERROR;
+    default:
+        return 0;
+    }
+}
+
+static int viewDataModelCheck(const MessageView& view) {
+    ValidationResult result;
+    try {
+        checkDataModelErrors(result, ROLE_TARGET, view);
+    } catch (...) {
+        // checkDataModelErrors() throws the library's internal failure type
+        return DATA_MODEL_ERROR;
+    }
+    return 0;
+}
+
+// Prints one line of JSON comparing the two data model checks on the generated
+// target messages. Parsing and building the views aren't timed, since both
+// checks need a parsed message. Returns false if the messages couldn't be generated.
+static bool runDataModelCheckBench(const BenchConfig& config, const std::string& icuVersion) {
+    Locale targetLocale(config.targetLocale.c_str());
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const LocalePluralCategories* targetCategories = getPluralCategories(targetLocale, errorCode);
+    if (U_FAILURE(errorCode)) {
+        cerr << format("Error getting plural rules for locale {}\n", config.targetLocale);
+        return false;
+    }
+
+    std::pmr::monotonic_buffer_resource arena;
+    std::vector<MessageView> views;
+    views.reserve(config.messages);
+    uint64_t formattingNanos = 0;
+    int disagreements = 0;
+    for (int i = 0; i < config.messages; i++) {
+        std::string message = generateMessage(targetCategories->categories, config, i);
+        UParseError parseError;
+        MessageFormatter::Builder builder(errorCode);
+        MessageFormatter mf = builder.setPattern(UnicodeString::fromUTF8(message), parseError, errorCode)
+            .setLocale(targetLocale)
+            .setErrorHandlingBehavior(MessageFormatter::U_MF_STRICT)
+            .build(errorCode);
+        if (U_FAILURE(errorCode)) {
+            cerr << format("Couldn't parse generated message {}\n", message);
+            return false;
+        }
+        views.emplace_back(mf.getDataModel(), &arena);
+
+        // Formatting takes microseconds, so timing each call is accurate enough
+        auto start = std::chrono::steady_clock::now();
+        int formattingStatus = formattingDataModelCheck(mf);
+        formattingNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (formattingStatus != viewDataModelCheck(views.back())) {
+            disagreements++;
+        }
+    }
+
+    // The view check is too quick to time one call at a time
+    int failures = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.messages; i++) {
+        if (viewDataModelCheck(views[i]) != 0) {
+            failures++;
+        }
+    }
+    uint64_t viewNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    double formattingPerMessage = static_cast<double>(formattingNanos) / config.messages;
+    double viewPerMessage = static_cast<double>(viewNanos) / config.messages;
+    cout << format("{{\"benchmark\":\"dataModelCheck\",\"icuVersion\":\"{}\",\"targetLocale\":\"{}\","
+                   "\"selectors\":{},\"targetVariants\":{},\"messages\":{},\"failures\":{},\"formattingNanosPerMessage\":{:.0f},"
+                   "\"viewNanosPerMessage\":{:.0f},\"speedup\":{:.1f},\"disagreements\":{}}}\n",
+                   icuVersion, config.targetLocale, config.selectors,
+                   config.selectors == 0 ? 1 : numTuples(targetCategories->categories.size(), config) + 1,
+                   config.messages, failures, formattingPerMessage, viewPerMessage,
+                   formattingPerMessage / std::max(viewPerMessage, 1.0), disagreements);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // Must come before anything else allocates through ICU
+    UErrorCode errorCode = U_ZERO_ERROR;
+    u_setMemoryFunctions(nullptr, icuAlloc, icuRealloc, icuFree, &errorCode);
+
+    cxxopts::Options options("mf2bench", "Benchmark the MF2 validator on generated messages");
+    options.add_options()
+        ("h,help", "Print out help message", cxxopts::value<bool>()->default_value("false"))
+        ("locales", "Comma-separated target locales (the source locale is always en)",
+         cxxopts::value<std::string>()->default_value("en,cs,ar,ru,pl"))
+        ("selectors", "Comma-separated numbers of selectors (0 means messages without .match)", cxxopts::value<std::string>()->default_value("1,2,3"))
+        ("variants", "Maximum number of variants besides the `*` variant (0 means one per tuple of plural categories)",
+         cxxopts::value<int>()->default_value("0"))
+        ("placeholders", "Number of placeholders in each variant besides the selectors",
+         cxxopts::value<int>()->default_value("2"))
+        ("variantSize", "Approximate number of bytes of text in each variant", cxxopts::value<int>()->default_value("40"))
+        ("messages", "Number of message pairs per combination of locale and selectors",
+         cxxopts::value<int>()->default_value("1000"))
+        ("compareDataModelCheck", "Instead of validating, compare the time taken by the data model check "
+         "with that of the formatting-based check it replaced",
+         cxxopts::value<bool>()->default_value("false"));
+    auto result = options.parse(argc, argv);
+    if (result["help"].as<bool>()) {
+        cout << options.help() << endl;
+        return 0;
+    }
+
+    UVersionInfo version;
+    u_getVersion(version);
+    char icuVersion[U_MAX_VERSION_STRING_LENGTH];
+    u_versionToString(version, icuVersion);
+
+    BenchConfig config;
+    config.maxVariants = result["variants"].as<int>();
+    config.placeholders = result["placeholders"].as<int>();
+    config.variantSize = result["variantSize"].as<int>();
+    config.messages = std::max(1, result["messages"].as<int>());
+    std::vector<std::string> locales = split(result["locales"].as<std::string>());
+    std::vector<std::string> selectorCounts = split(result["selectors"].as<std::string>());
+    for (auto locale = locales.begin(); locale != locales.end(); ++locale) {
+        for (auto selectors = selectorCounts.begin(); selectors != selectorCounts.end(); ++selectors) {
+            config.targetLocale = *locale;
+            config.selectors = std::atoi(selectors->c_str());
+            bool ok = result["compareDataModelCheck"].as<bool>() ? runDataModelCheckBench(config, icuVersion)
+                                                                  : runBench(config, icuVersion);
+            if (!ok) {
+                return ICU_INTERNAL_ERROR;
+            }
+        }
+    }
+    return 0;
+}
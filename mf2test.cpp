@@ -0,0 +1,131 @@
+// Runs a table of test cases in-process and in parallel, without starting
+// a process (and loading ICU data) for each case.
+//
+// Each non-blank line of a table that doesn't start with '#' has the form:
+//   sourceFile targetFile expectedExitCode [sourceLocale targetLocale]
+// File names are relative to the directory the table is in. The locales
+// default to en-US and cs-CZ.
+//
+// Exits with 1 if any case fails.
+
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "libmf2validate.h"
+#include "mappedfile.h"
+#include "parallel.h"
+
+using namespace icu;
+using namespace std;
+
+struct TestCase {
+    // Where the case came from, for error messages
+    std::string location;
+    std::string sourceFilename;
+    std::string targetFilename;
+    int expected;
+    std::string sourceLocale;
+    std::string targetLocale;
+    int actual = 0;
+};
+
+// Appends the cases in `tableFilename` to `cases`. Returns false if the table
+// can't be read or has a malformed line.
+static bool readTable(const std::string& tableFilename, std::vector<TestCase>& cases) {
+    std::ifstream table(tableFilename);
+    if (!table) {
+        cout << format("Error reading from file {}\n", tableFilename);
+        return false;
+    }
+    size_t slash = tableFilename.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : tableFilename.substr(0, slash + 1);
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(table, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        TestCase testCase;
+        testCase.location = format("{}:{}", tableFilename, lineNumber);
+        if (!(fields >> testCase.sourceFilename) || testCase.sourceFilename[0] == '#') {
+            continue;
+        }
+        if (!(fields >> testCase.targetFilename >> testCase.expected)) {
+            cout << format("{}: expected sourceFile targetFile expectedExitCode [sourceLocale targetLocale]\n",
+                           testCase.location);
+            return false;
+        }
+        if (!(fields >> testCase.sourceLocale >> testCase.targetLocale)) {
+            testCase.sourceLocale = "en-US";
+            testCase.targetLocale = "cs-CZ";
+        }
+        testCase.sourceFilename = directory + testCase.sourceFilename;
+        testCase.targetFilename = directory + testCase.targetFilename;
+        cases.push_back(std::move(testCase));
+    }
+    return true;
+}
+
+// Returns the exit code that mf2validate would give for this case
+static int runCase(const TestCase& testCase) {
+    MappedFile sourceFile;
+    MappedFile targetFile;
+    if (!sourceFile.open(testCase.sourceFilename) || !targetFile.open(testCase.targetFilename)) {
+        return IO_ERROR;
+    }
+    return validateMessages(Locale(testCase.sourceLocale.c_str()), Locale(testCase.targetLocale.c_str()),
+                            sourceFile.contents(), targetFile.contents()).status;
+}
+
+int main(int argc, char** argv) {
+    cxxopts::Options options("mf2test", "Run tables of MF2 validator test cases");
+    options.add_options()
+        ("h,help", "Print out help message", cxxopts::value<bool>()->default_value("false"))
+        ("verbose", "Print passing cases too", cxxopts::value<bool>()->default_value("false"))
+        ("j,jobs", "Number of threads to use (0 means one per core)", cxxopts::value<int>()->default_value("0"))
+        ("tables", "Files listing test cases", cxxopts::value<std::vector<std::string>>());
+    options.parse_positional({ "tables" });
+    options.positional_help("TABLE...");
+    auto result = options.parse(argc, argv);
+    if (result["help"].as<bool>() || result.count("tables") == 0) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    bool verbose = result["verbose"].as<bool>();
+    int jobs = result["jobs"].as<int>();
+    if (jobs <= 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<TestCase> cases;
+    std::vector<std::string> tables = result["tables"].as<std::vector<std::string>>();
+    for (auto it = tables.begin(); it != tables.end(); ++it) {
+        if (!readTable(*it, cases)) {
+            return 1;
+        }
+    }
+
+    parallelFor(cases.size(), jobs, [&cases](size_t i) {
+        cases[i].actual = runCase(cases[i]);
+    });
+
+    int failures = 0;
+    for (auto it = cases.begin(); it != cases.end(); ++it) {
+        if (it->actual != it->expected) {
+            failures++;
+            cout << format("*** Test failed ***: {}: ({}, {}); expected {} and got {}\n", it->location,
+                           it->sourceFilename, it->targetFilename, it->expected, it->actual);
+        } else if (verbose) {
+            cout << format("Test passed: ({}, {})\n", it->sourceFilename, it->targetFilename);
+        }
+    }
+    cout << format("{} cases run, {} failed\n", cases.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
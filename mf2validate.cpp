@@ -1,69 +1,91 @@
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <fstream>
 #include <iostream>
-#include <math.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 #include <cxxopts.hpp>
 
-#include <unicode/messageformat2.h>
-#include <unicode/messageformat2_data_model.h>
+#include "catalog.h"
+#include "filewatcher.h"
+#include "libmf2validate.h"
+#include "mappedfile.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "report.h"
+#include "resultcache.h"
+#include "server.h"
+#include "shard.h"
+#include "stats.h"
 
 using namespace icu;
-using namespace message2;
 using namespace std;
 
-#define MISSING_PLURAL_CATEGORY 1
-#define PARSE_ERROR 2
-#define NOT_YET_IMPLEMENTED 3
-#define DATA_MODEL_ERROR 4
-#define ICU_INTERNAL_ERROR 5
-#define NON_PLURAL_SELECTORS 6
-#define ASSERTION_FAILED 7
-#define IO_ERROR 8
-#define PARTIAL_WILDCARDS 9
-#define INCONSISTENT_PLACEHOLDERS 10
-
 bool quiet;
-
+// Set if --cache is given
+ResultCache* resultCache = nullptr;
+// Set if --stats is given
+ValidationStats* stats = nullptr;
+// Set by --format
+OutputFormat outputFormat = FORMAT_TEXT;
+RecordWriter* writer = nullptr;
+// Set by --memoryBudget, in bytes
+size_t memoryBudget;
+// Set by --shard; without it, every entry is in shard 0/1
+Shard shard;
+// Set if --shard is given
+ShardWriter* shardWriter = nullptr;
+
+// Output isn't flushed line by line; see main()
 void log(std::string s) {
     if (!quiet) {
-        cout << s << endl;
+        cout << s << '\n';
     }
 }
 
-std::string fromUStr(const UnicodeString& uStr) {
-    std::string str;
-    return uStr.toUTF8String(str);
-}
-
-std::string readFile(std::string filename) {
-    std::ifstream file(filename);
-    std::string line;
-    std::string contents;
-    if (!file) {
-        log(format("Error reading from file {}", filename));
-        exit(IO_ERROR);
-    }
-    while (std::getline(file, line)) {
-        contents += line;
-        contents.push_back('\n');
+// For output that is buffered, and so shouldn't be flushed line by line
+void log(std::ostream& out, const std::string& s) {
+    if (!quiet) {
+        out << s << '\n';
     }
-    return contents;
 }
 
-std::string localeToString(const Locale& locale) {
-    UErrorCode status = U_ZERO_ERROR;
-    std::string result = locale.toLanguageTag<std::string>(status);
-    if (U_FAILURE(status)) {
-        return "[Bad locale]";
-    }
-    return result;
-}
+struct Options {
+    Locale sourceLocale;
+    Locale targetLocale;
+    std::string sourceFilename;
+    std::string targetFilename;
+    std::string manifestFilename;
+    std::string sourceCatalogFilename;
+    std::string targetCatalogFilename;
+    // LOCALE=FILE
+    std::vector<std::string> targets;
+    std::string cacheDirectory;
+    std::string statsFilename;
+    bool serve;
+    std::string socketPath;
+    OutputFormat format;
+    int jobs;
+    size_t memoryBudget;
+    bool watch;
+    std::string shard;
+    std::string shardFilename;
+    // "merge" to merge shard files, or empty
+    std::string command;
+    // The shard files to merge
+    std::vector<std::string> files;
+    std::string formatName;
+    bool verbose;
+};
 
-void getOptions(int argc, char** argv,
-                Locale& sourceLocale, Locale& targetLocale,
-                std::string& sourceFilename, std::string& targetFilename,
-                bool& verbose, bool& quiet) {
+void getOptions(int argc, char** argv, Options& opts, bool& quiet) {
     cxxopts::Options options("mf2validate", "Validate a source and target MF2 message");
     options.add_options()
         ("h,help", "Print out help message", cxxopts::value<bool>()->default_value("false"))
@@ -72,38 +94,104 @@ void getOptions(int argc, char** argv,
         ("sourceLocale", "Locale for source message", cxxopts::value<std::string>()->default_value(""))
         ("targetLocale", "Locale for target message", cxxopts::value<std::string>()->default_value(""))
         ("sourceFilename", "File name for source message", cxxopts::value<std::string>()->default_value(""))
-        ("targetFilename", "File name for target message", cxxopts::value<std::string>()->default_value(""));
+        ("targetFilename", "File name for target message", cxxopts::value<std::string>()->default_value(""))
+        ("manifest", "File listing (sourceLocale, targetLocale, sourceFilename, targetFilename) entries to validate in one run",
+         cxxopts::value<std::string>()->default_value(""))
+        ("sourceCatalog", "File name for source message catalog (JSON if it ends in .json, otherwise `id = message` lines)",
+         cxxopts::value<std::string>()->default_value(""))
+        ("targetCatalog", "File name for target message catalog", cxxopts::value<std::string>()->default_value(""))
+        ("target", "Validate the source message against each target, given as LOCALE=FILE (repeat the flag or separate with commas)",
+         cxxopts::value<std::vector<std::string>>())
+        ("j,jobs", "Number of threads to use in batch, catalog and --target modes (0 means one per core)",
+         cxxopts::value<int>()->default_value("1"))
+        ("memoryBudget", "Approximate number of megabytes of messages and output to hold at once in batch, catalog and --target modes",
+         cxxopts::value<int>()->default_value("64"))
+        ("cache", "Directory in which to cache results, so that unchanged messages aren't checked again",
+         cxxopts::value<std::string>()->default_value(""))
+        ("stats", "File to write timing and other statistics to, as JSON (- for standard output)",
+         cxxopts::value<std::string>()->default_value(""))
+        ("watch", "Validate again each time a message file or catalog is saved, until interrupted",
+         cxxopts::value<bool>()->default_value("false"))
+        ("serve", "Answer validation requests (one JSON object per line) on standard input, or on --socket",
+         cxxopts::value<bool>()->default_value("false"))
+        ("socket", "Unix domain socket to listen on in --serve mode", cxxopts::value<std::string>()->default_value(""))
+        ("format", "Output format: text, jsonl (one JSON record per line) or sarif",
+         cxxopts::value<std::string>()->default_value("text"))
+        ("shard", "Only validate shard i of N (given as i/N) of the entries in batch, catalog and --target modes",
+         cxxopts::value<std::string>()->default_value(""))
+        ("shardFile", "File to write the shard's results to, for `mf2validate merge`",
+         cxxopts::value<std::string>()->default_value(""))
+        ("command", "", cxxopts::value<std::string>()->default_value(""))
+        ("files", "", cxxopts::value<std::vector<std::string>>());
+    options.parse_positional({ "command", "files" });
+    options.positional_help("[merge SHARD_FILE...]");
     auto result = options.parse(argc, argv);
 
     try {
-        sourceLocale = Locale(result["sourceLocale"].as<std::string>().c_str());
+        opts.sourceLocale = Locale(result["sourceLocale"].as<std::string>().c_str());
     } catch (const cxxopts::exceptions::exception& e) {
         log("Must provide --sourceLocale flag");
         throw(e);
     }
 
     try {
-        targetLocale = Locale(result["targetLocale"].as<std::string>().c_str());
+        opts.targetLocale = Locale(result["targetLocale"].as<std::string>().c_str());
     } catch (const cxxopts::exceptions::exception& e) {
         log("Must provide --targetLocale flag");
         throw(e);
     }
 
     try {
-        sourceFilename = result["sourceFilename"].as<std::string>();
+        opts.sourceFilename = result["sourceFilename"].as<std::string>();
     } catch (const cxxopts::exceptions::exception& e) {
         log("Must provide --sourceFilename flag");
         throw(e);
     }
 
     try {
-        targetFilename = result["targetFilename"].as<std::string>();
+        opts.targetFilename = result["targetFilename"].as<std::string>();
     } catch (const cxxopts::exceptions::exception& e) {
         log("Must provide --targetFilename flag");
         throw(e);
     }
 
-    verbose = result["verbose"].as<bool>();
+    opts.manifestFilename = result["manifest"].as<std::string>();
+    opts.sourceCatalogFilename = result["sourceCatalog"].as<std::string>();
+    opts.targetCatalogFilename = result["targetCatalog"].as<std::string>();
+    if (result.count("target") != 0) {
+        opts.targets = result["target"].as<std::vector<std::string>>();
+    }
+    opts.cacheDirectory = result["cache"].as<std::string>();
+    opts.statsFilename = result["stats"].as<std::string>();
+    opts.watch = result["watch"].as<bool>();
+    opts.shard = result["shard"].as<std::string>();
+    opts.shardFilename = result["shardFile"].as<std::string>();
+    opts.command = result["command"].as<std::string>();
+    if (result.count("files") != 0) {
+        opts.files = result["files"].as<std::vector<std::string>>();
+    }
+    if (!opts.command.empty() && opts.command != "merge") {
+        cout << format("Unknown command {}; the only command is merge", opts.command) << endl;
+        exit(IO_ERROR);
+    }
+    opts.serve = result["serve"].as<bool>();
+    opts.socketPath = result["socket"].as<std::string>();
+    opts.formatName = result["format"].as<std::string>();
+    if (!outputFormatFromString(opts.formatName, opts.format)) {
+        cout << "--format must be text, jsonl or sarif" << endl;
+        exit(IO_ERROR);
+    }
+    opts.jobs = result["jobs"].as<int>();
+    if (opts.jobs <= 0) {
+        opts.jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    int memoryBudgetMB = result["memoryBudget"].as<int>();
+    if (memoryBudgetMB <= 0) {
+        cout << "--memoryBudget must be a positive number of megabytes" << endl;
+        exit(IO_ERROR);
+    }
+    opts.memoryBudget = static_cast<size_t>(memoryBudgetMB) * 1024 * 1024;
+    opts.verbose = result["verbose"].as<bool>();
     bool help = result["help"].as<bool>();
     quiet = result["quiet"].as<bool>();
 
@@ -113,552 +201,932 @@ void getOptions(int argc, char** argv,
     }
 }
 
-void echoOptions(const Locale& sourceLocale, const Locale& targetLocale,
-                 std::string sourceMessage, std::string targetMessage) {
-    cout << "=== Options provided ===\n";
-    cout << "Source locale: " << localeToString(sourceLocale) << "\n";
-    cout << "Target locale: " << localeToString(targetLocale) << "\n";
-    cout << "== Source message ==\n";
-    cout << sourceMessage;
-    cout << "== Target message ==\n";
-    cout << targetMessage;
+void echoOptions(std::ostream& out, const Locale& sourceLocale, const Locale& targetLocale,
+                 std::string_view sourceMessage, std::string_view targetMessage) {
+    out << "=== Options provided ===\n";
+    out << "Source locale: " << localeToString(sourceLocale) << "\n";
+    out << "Target locale: " << localeToString(targetLocale) << "\n";
+    out << "== Source message ==\n";
+    out << sourceMessage;
+    out << "== Target message ==\n";
+    out << targetMessage;
 }
 
-void checkICUError(UErrorCode errorCode, std::string errorMessage) {
-    if (U_FAILURE(errorCode)) {
-        log(errorMessage);
-        exit(ICU_INTERNAL_ERROR);
+// Calls `validate` with somewhere to put phase times, and records statistics, if they're enabled
+ValidationResult recordStats(size_t bytes, const std::function<ValidationResult(PhaseTimes*)>& validate) {
+    // Timing is only done with --stats
+    PhaseTimes times;
+    PhaseTimes* timesOrNull = stats ? &times : nullptr;
+    auto start = stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    ValidationResult result = validate(timesOrNull);
+    if (stats) {
+        uint64_t totalNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        stats->record(times, totalNanos, result.status, bytes);
     }
+    return result;
 }
 
-int fact(int n) {
-    if (n <= 1) {
-        return 1;
-    }
-    return n * fact(n - 1);
+// Validates with the result cache and records statistics, if they're enabled
+ValidationResult runValidation(const Locale& sourceLocale, const Locale& targetLocale,
+                               std::string_view sourceMessage, std::string_view targetMessage) {
+    return recordStats(sourceMessage.size() + targetMessage.size(), [&](PhaseTimes* times) {
+        return resultCache
+            ? resultCache->validateMessages(sourceLocale, targetLocale, sourceMessage, targetMessage, times)
+            : validateMessages(sourceLocale, targetLocale, sourceMessage, targetMessage, times);
+    });
 }
 
-int perms(int n, int k) {
-    return std::floor(pow(n, k));
+// The same, for a source message that has already been analyzed. The time spent
+// on the source message isn't counted again for each target.
+ValidationResult runTargetValidation(const SourceAnalysis& source, const Locale& targetLocale,
+                                     std::string_view targetMessage) {
+    return recordStats(source.message().size() + targetMessage.size(), [&](PhaseTimes* times) {
+        return resultCache
+            ? resultCache->validate(source, targetLocale, targetMessage, times)
+            : source.validate(targetLocale, targetMessage, times);
+    });
 }
 
-std::vector<UnicodeString> insertElementAt(std::vector<UnicodeString> v,
-                                           UnicodeString s,
-                                           int i) {
-    std::vector<UnicodeString> result;
-    for (int j = 0; j < i; j++) {
-        result.push_back(v[j]);
+// Writes `diagnostic` to `out` in the output format. SARIF logs only have
+// failures in them, and so do JSON Lines with -q.
+void report(std::ostream& out, const EntryContext& context, const Diagnostic& diagnostic) {
+    if (outputFormat == FORMAT_TEXT) {
+        log(out, diagnostic.message);
+        return;
     }
-    result.push_back(s);
-    for (int j = i + 1; j < v.size() + 1; j++) {
-        result.push_back(v[j - 1]);
+    if (diagnostic.code == 0 && (quiet || outputFormat == FORMAT_SARIF)) {
+        return;
     }
-    return result;
+    out << diagnosticRecord(outputFormat, context, diagnostic);
 }
 
-template <class T>
-bool contains(std::vector<T> vs, T v) {
-    for (auto it = vs.begin(); it != vs.end(); ++it) {
-        if (*it == v) {
-            return true;
-        }
-    }
-    return false;
+// For diagnostics that aren't part of any entry's output
+void report(const EntryContext& context, int code, const std::string& message) {
+    std::ostringstream out;
+    report(out, context, { code, message });
+    writer->write(out.str());
 }
 
-std::vector<std::vector<UnicodeString>> dedup(std::vector<std::vector<UnicodeString>> v) {
-    std::vector<std::vector<UnicodeString>> result;
-
-    for (auto it = v.begin(); it != v.end(); ++it) {
-        if (!contains<std::vector<UnicodeString>>(result, *it)) {
-            result.push_back(*it);
-        }
+// Reports the diagnostics in `result`, and returns its exit code
+int logResult(std::ostream& out, const EntryContext& context, const ValidationResult& result) {
+    for (auto it = result.diagnostics.begin(); it != result.diagnostics.end(); ++it) {
+        report(out, context, *it);
     }
-
-    return result;
+    return result.status;
 }
 
-std::vector<std::vector<UnicodeString>> insertEverywhere(UnicodeString element,
-                                                         std::vector<std::vector<UnicodeString>> permutations) {
-    std::vector<std::vector<UnicodeString>> result;
-
-    if (permutations.size() == 0) {
-        result.push_back({ element });
-        return result;
+int validateAndLog(std::ostream& out, const EntryContext& context,
+                   const Locale& sourceLocale, const Locale& targetLocale,
+                   std::string_view sourceMessage, std::string_view targetMessage,
+                   bool verbose) {
+    if (verbose && outputFormat == FORMAT_TEXT) {
+        echoOptions(out, sourceLocale, targetLocale, sourceMessage, targetMessage);
     }
 
-    int positions = permutations[0].size() + 1;
-    for (auto perm = permutations.begin(); perm != permutations.end(); ++perm) {
-        for (int i = 0; i < positions; i++) {
-            result.push_back(insertElementAt(*perm, element, i));
-        }
-    }
-    return result;
+    return logResult(out, context, runValidation(sourceLocale, targetLocale, sourceMessage, targetMessage));
 }
 
-// The permutation-generating code isn't too efficient, but we expect `len` to be small.
-std::vector<std::vector<UnicodeString>> generatePermutations(int len, std::vector<UnicodeString> strings) {
-
-    std::vector<std::vector<UnicodeString>> result;
-    if (len == 0) {
-        return result;
+// For entries that fail without being validated
+int countFailure(int status) {
+    if (stats) {
+        stats->recordExitCode(status);
     }
-    for (auto category = strings.begin(); category != strings.end(); ++category) {
-        auto tail = insertEverywhere(*category, generatePermutations(len - 1, strings));
-        result.insert(result.end(), tail.begin(), tail.end());
-    }
-    return dedup(result);
+    return status;
 }
 
-std::vector<UnicodeString> stringEnumerationToVector(StringEnumeration& strings) {
-    UErrorCode errorCode = U_ZERO_ERROR;
-
-    const UnicodeString* category;
-    std::vector<UnicodeString> stringVector;
-    while ((category = strings.snext(errorCode)) != nullptr) {
-        checkICUError(errorCode,
-                      format("Internal error iterating over plural categories"));
-        stringVector.push_back(*category);
+// Validates the messages in `context.sourceFile` and `context.targetFile`
+int validate(std::ostream& out, const EntryContext& context,
+             const Locale& sourceLocale, const Locale& targetLocale,
+             bool verbose) {
+    MappedFile sourceFile;
+    MappedFile targetFile;
+    if (!sourceFile.open(context.sourceFile)) {
+        report(out, context, { IO_ERROR, format("Error reading from file {}", context.sourceFile), ROLE_SOURCE });
+        return countFailure(IO_ERROR);
+    }
+    if (!targetFile.open(context.targetFile)) {
+        report(out, context, { IO_ERROR, format("Error reading from file {}", context.targetFile), ROLE_TARGET });
+        return countFailure(IO_ERROR);
     }
 
-    return stringVector;
+    return validateAndLog(out, context, sourceLocale, targetLocale, sourceFile.contents(), targetFile.contents(),
+                          verbose);
 }
 
-UnicodeString keyToString(const Key& k) {
-    return k.asLiteral().unquoted();
+std::string resultCacheSummary() {
+    ResultCacheStats stats = resultCache->stats();
+    return format("Result cache: {} hits, {} misses, {:.3f}s saved", stats.hits, stats.misses, stats.secondsSaved);
 }
 
-bool checkValidKeys(const Locale& locale,
-                    const std::vector<Variant>& variants,
-                    const std::vector<UnicodeString>& pluralCategories) {
-    for (auto it = variants.begin(); it != variants.end(); ++it) {
-        const std::vector<Key> sKeys = it->getKeys().getKeys();
-        for (auto k = sKeys.begin(); k != sKeys.end(); ++k) {
-            if (k->isWildcard()) {
-                continue;
-            }
-            UnicodeString ks = keyToString(*k);
-            if (!contains<UnicodeString>(pluralCategories, ks)) {
-                log(format("Key {} is not a valid plural category for locale {}.",
-                                fromUStr(ks), localeToString(locale)));
-                return false;
-            }
+// Runs the entries of a batch or catalog validation on `jobs` threads, in a
+// Pipeline whose window is bounded by --memoryBudget, so that memory use
+// doesn't grow with the number of entries. Each entry's output goes to its
+// own buffer, and the buffers are printed in the order the entries were added,
+// each followed by the entry's result record. With --shard, only the entries
+// in the shard are run, and their output goes to the shard file.
+class Batch {
+public:
+    explicit Batch(int jobs) : pipeline(jobs, std::max(1024, 64 * jobs), memoryBudget) {}
+
+    // `task` writes its output to the given stream and returns an exit code.
+    // `context` identifies the entry in its result record. `bytes` is the size
+    // of the input that `task` holds on to.
+    void add(std::function<int(std::ostream&)> task, EntryContext context, size_t bytes) {
+        // Entries are numbered as in an unsharded run, so that shards can be merged
+        size_t number = added++;
+        // All the targets of a source message are in the same shard
+        if (shardWriter && !shard.contains(context.messageId.empty() ? context.sourceFile : context.messageId)) {
+            return;
         }
+        pipeline.add(std::move(task), [this, context = std::move(context), number](const std::string& output,
+                                                                                   int result) {
+                         std::string records = output + resultRecord(outputFormat, context, result);
+                         if (shardWriter) {
+                             shardWriter->add(number, result, records);
+                         } else {
+                             writer->write(records);
+                         }
+                         entries++;
+                         if (result != 0) {
+                             failures++;
+                             if (aggregateResult == 0) {
+                                 aggregateResult = result;
+                             }
+                         }
+                     }, bytes);
     }
-    return true;
-}
 
-bool isPluralSelector(const MFDataModel& dataModel,
-                      const VariableName& variableName) {
-    UErrorCode status = U_ZERO_ERROR;
-
-    // Check if this variable's RHS has a `:number` annotation
-    // Walk through all local variable declarations
-    std::vector<Binding> decls = dataModel.getLocalVariables();
-    for (auto it = decls.begin(); it != decls.end(); ++it) {
-        if (it->getVariable() == variableName) {
-            const Expression& rhs = it->getValue();
-            const Operator* rator = rhs.getOperator(status);
-            if (U_FAILURE(status)) {
-                // Also need to handle aliasing: we could have
-                // .local $x = {$y} where $y has a selector annotation
-                if (rhs.getOperand().isVariable()) {
-                    return isPluralSelector(dataModel, rhs.getOperand().asVariable());
-                }
-                // Otherwise, RHS must be an unannotated literal
-                return false;
+    // Waits for the remaining entries and prints a summary. Returns the exit code
+    // of the first entry that failed (or 0 if all entries passed). `complete` is
+    // false if the input couldn't all be read, in which case the shard file, if
+    // any, is left without its trailer, so that it can't be merged.
+    int finish(const std::string& entryName, bool complete = true) {
+        pipeline.finish();
+        if (shardWriter && complete && !shardWriter->finish(added, entryName)) {
+            report({}, IO_ERROR, format("Error writing to file {}", shardWriter->filename()));
+            if (aggregateResult == 0) {
+                aggregateResult = IO_ERROR;
             }
-            if (rator->getFunctionName() == UnicodeString("number")) {
-                return true;
+        }
+        PluralCacheStats cacheStats = pluralCacheStats();
+        uint64_t peakBytes = peakMemoryBytes();
+        if (outputFormat == FORMAT_TEXT) {
+            cout << format("{} {} validated, {} failed\n", entries, entryName, failures);
+            cout << format("Plural rules cache: {} hits, {} misses\n", cacheStats.hits, cacheStats.misses);
+            if (resultCache) {
+                cout << resultCacheSummary() << '\n';
             }
-            // This means `variableName`'s RHS has an annotation that isn't the plural selector/formatter
-            return false;
+            cout << format("Peak memory use: {:.1f} MB\n", peakBytes / (1024.0 * 1024.0));
+        } else if (outputFormat == FORMAT_JSONL) {
+            cout << format("{{\"type\":\"summary\",\"validated\":{},\"failed\":{},"
+                           "\"pluralCacheHits\":{},\"pluralCacheMisses\":{}",
+                           entries, failures, cacheStats.hits, cacheStats.misses);
+            if (resultCache) {
+                ResultCacheStats resultCacheStats = resultCache->stats();
+                cout << format(",\"resultCacheHits\":{},\"resultCacheMisses\":{},\"resultCacheSecondsSaved\":{:.3f}",
+                               resultCacheStats.hits, resultCacheStats.misses, resultCacheStats.secondsSaved);
+            }
+            cout << format(",\"peakMemoryBytes\":{}}}\n", peakBytes);
         }
+        return aggregateResult;
     }
-    // Variable is unbound, which means the message has an "unresolved variable" error, but we
-    // just ignore that case
-    return false;
-}
 
-bool allWildcards(const std::vector<Key>& keys) {
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-        if (!it->isWildcard()) {
-            return false;
-        }
+private:
+    // The number of entries added, including those in other shards
+    size_t added = 0;
+    // Only changed on the pipeline's emitter thread
+    int aggregateResult = 0;
+    int entries = 0;
+    int failures = 0;
+    // Last, so that its threads are stopped before the counters go away
+    Pipeline pipeline;
+};
+
+// Each non-blank line of the manifest that doesn't start with '#' has the form:
+//   sourceLocale targetLocale sourceFilename targetFilename
+// Prints one result record per entry, and returns the exit code
+// of the first entry that failed (or 0 if all entries passed)
+int validateManifest(const std::string& manifestFilename, int jobs, bool verbose) {
+    // Problems with the manifest itself are reported as if it were the target file
+    EntryContext manifestContext;
+    manifestContext.targetFile = manifestFilename;
+    std::ifstream manifest(manifestFilename);
+    if (!manifest) {
+        report(manifestContext, IO_ERROR, format("Error reading from file {}", manifestFilename));
+        return IO_ERROR;
     }
-    return true;
-}
 
-bool partialWildcards(const std::vector<Key>& keys) {
-    bool wildcardSeen = false;
-    bool nonWildcardSeen = false;
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-        if (it->isWildcard()) {
-            wildcardSeen = true;
-        } else {
-            nonWildcardSeen = true;
+    Batch batch(jobs);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(manifest, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string sourceLocaleTag, targetLocaleTag, sourceFilename, targetFilename;
+        if (!(fields >> sourceLocaleTag) || sourceLocaleTag[0] == '#') {
+            continue;
+        }
+        if (!(fields >> targetLocaleTag >> sourceFilename >> targetFilename)) {
+            report(manifestContext, IO_ERROR,
+                   format("{}:{}: expected four fields: sourceLocale targetLocale sourceFilename targetFilename",
+                          manifestFilename, lineNumber));
+            return IO_ERROR;
         }
+
+        EntryContext context { "", sourceLocaleTag, targetLocaleTag, sourceFilename, targetFilename };
+        batch.add([=](std::ostream& out) {
+                      return validate(out, context, Locale(sourceLocaleTag.c_str()), Locale(targetLocaleTag.c_str()),
+                                      verbose);
+                  },
+                  context, line.size());
     }
-    return wildcardSeen && nonWildcardSeen;
+    return batch.finish("entries");
 }
 
-bool keysEqual(const std::vector<Key>& variantKeys,
-               const std::vector<UnicodeString>& expectedKeys) {
-    // variantKeys.size() == expectedKeys.size() (already checked)
-    for (int i = 0; i < variantKeys.size(); i++) {
-        if (keyToString(variantKeys[i]) != expectedKeys[i]) {
-            return false;
-        }
-    }
-    return true;
+struct SourceCatalogEntry {
+    std::string id;
+    std::string message;
+    bool matched;
+    // True if the ID appears more than once in the source catalog
+    bool duplicate;
+};
+
+// Reported with the first entry of a message ID that appears more than once in
+// the source catalog, so that it goes wherever that entry's output goes
+Diagnostic sourceDuplicateWarning(const std::string& id) {
+    return { 0, format("Warning: message ID {} appears more than once in source catalog; using the last one", id),
+             ROLE_SOURCE };
 }
 
-std::string uStrsToString(const std::vector<UnicodeString>& keys) {
-    std::string result;
-    bool first = true;
+// Validates every message whose ID is in both catalogs, and reports the IDs
+// that are only in one of them. The source catalog's messages are kept in
+// memory; the target catalog is validated as it is read.
+// Prints one result record per message ID, and returns the exit code
+// of the first message that failed (or 0 if all messages passed)
+int validateCatalogs(const Locale& sourceLocale, const Locale& targetLocale,
+                     const std::string& sourceCatalogFilename, const std::string& targetCatalogFilename,
+                     int jobs, bool verbose) {
+    EntryContext catalogContext { "", localeToString(sourceLocale), localeToString(targetLocale),
+                                  sourceCatalogFilename, targetCatalogFilename };
+    // Returns the context for one message ID
+    auto messageContext = [&catalogContext](const std::string& id) {
+        EntryContext context = catalogContext;
+        context.messageId = id;
+        return context;
+    };
+
+    MappedFile sourceFile;
+    if (!sourceFile.open(sourceCatalogFilename)) {
+        report(catalogContext, IO_ERROR, format("Error reading from file {}", sourceCatalogFilename));
+        return IO_ERROR;
+    }
+    MappedFile targetFile;
+    if (!targetFile.open(targetCatalogFilename)) {
+        report(catalogContext, IO_ERROR, format("Error reading from file {}", targetCatalogFilename));
+        return IO_ERROR;
+    }
 
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-        if (!first) {
-            result += ' ';
+    std::vector<SourceCatalogEntry> sourceEntries;
+    std::unordered_map<std::string, size_t> sourceIndex;
+    CatalogReader sourceReader(sourceFile.contents(), catalogFormatFor(sourceCatalogFilename));
+    std::string id;
+    std::string message;
+    while (sourceReader.next(id, message)) {
+        auto [it, inserted] = sourceIndex.emplace(id, sourceEntries.size());
+        if (!inserted) {
+            sourceEntries[it->second].message = message;
+            sourceEntries[it->second].duplicate = true;
+            continue;
         }
-        first = false;
-        std::string temp;
-        result += it->toUTF8String(temp);
+        sourceEntries.push_back({ id, message, false, false });
     }
-    return result;
-}
-
-std::string keysToString(const std::vector<Key>& keys) {
-    std::vector<UnicodeString> strings;
-
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-        strings.push_back(keyToString(*it));
+    if (!sourceReader.error().empty()) {
+        report(catalogContext, IO_ERROR, format("{}: {}", sourceCatalogFilename, sourceReader.error()));
+        return IO_ERROR;
     }
-    return uStrsToString(strings);
-}
 
-bool allOther(const std::vector<UnicodeString>& keys) {
-    UnicodeString other("other");
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-        if (*it != other) {
-            return false;
+    Batch batch(jobs);
+    CatalogReader targetReader(targetFile.contents(), catalogFormatFor(targetCatalogFilename));
+    while (targetReader.next(id, message)) {
+        auto it = sourceIndex.find(id);
+        if (it == sourceIndex.end()) {
+            EntryContext context = messageContext(id);
+            batch.add([context](std::ostream& out) {
+                          report(out, context, { CATALOG_MISMATCH,
+                                  format("Message ID {} is in the target catalog but not the source catalog",
+                                         context.messageId), ROLE_TARGET });
+                          return countFailure(CATALOG_MISMATCH);
+                      }, context, id.size());
+            continue;
         }
+        SourceCatalogEntry& sourceEntry = sourceEntries[it->second];
+        bool targetDuplicate = sourceEntry.matched;
+        // Only the first target entry with this ID reports the source duplicate
+        bool sourceDuplicate = sourceEntry.duplicate && !targetDuplicate;
+        sourceEntry.matched = true;
+        // sourceEntries doesn't change from here on, so the task can refer to the source message
+        const std::string* sourceMessage = &sourceEntry.message;
+        EntryContext context = messageContext(id);
+        batch.add([&sourceLocale, &targetLocale, context, sourceMessage, targetMessage = message,
+                   sourceDuplicate, targetDuplicate, verbose](std::ostream& out) {
+                      if (sourceDuplicate) {
+                          report(out, context, sourceDuplicateWarning(context.messageId));
+                      }
+                      if (targetDuplicate) {
+                          report(out, context, { 0, format("Warning: message ID {} appears more than once in target catalog",
+                                                           context.messageId), ROLE_TARGET });
+                      }
+                      if (outputFormat == FORMAT_TEXT) {
+                          log(out, format("=== Message ID {} ===", context.messageId));
+                      }
+                      return validateAndLog(out, context, sourceLocale, targetLocale, *sourceMessage, targetMessage,
+                                            verbose);
+                  }, context, message.size());
+    }
+    if (!targetReader.error().empty()) {
+        batch.finish("messages", false);
+        report(catalogContext, IO_ERROR, format("{}: {}", targetCatalogFilename, targetReader.error()));
+        return IO_ERROR;
     }
-    return true;
-}
 
-bool allOther(const std::vector<Key>& keys) {
-    UnicodeString other("other");
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-        if (it->isWildcard()) {
-            return false;
-        }
-        if (keyToString(*it) != other) {
-            return false;
+    for (auto it = sourceEntries.begin(); it != sourceEntries.end(); ++it) {
+        if (!it->matched) {
+            EntryContext context = messageContext(it->id);
+            batch.add([context, duplicate = it->duplicate](std::ostream& out) {
+                          if (duplicate) {
+                              report(out, context, sourceDuplicateWarning(context.messageId));
+                          }
+                          report(out, context, { CATALOG_MISMATCH,
+                                  format("Message ID {} is in the source catalog but not the target catalog",
+                                         context.messageId), ROLE_SOURCE });
+                          return countFailure(CATALOG_MISMATCH);
+                      }, context, it->id.size());
         }
     }
-    return true;
+
+    return batch.finish("messages");
 }
 
-bool missingOtherVariant(const std::vector<Variant>& variants) {
-    for (auto it = variants.begin(); it != variants.end(); ++it) {
-        if (allOther(it->getKeys().getKeys())) {
+// Sets `contexts` to the contexts of `targets`, given as LOCALE=FILE, on top of
+// `sourceContext`. Reports the first malformed target and returns false if there is one.
+bool parseTargets(const std::vector<std::string>& targets, const EntryContext& sourceContext,
+                  std::vector<EntryContext>& contexts) {
+    for (auto it = targets.begin(); it != targets.end(); ++it) {
+        size_t equals = it->find('=');
+        if (equals == 0 || equals == std::string::npos || equals == it->size() - 1) {
+            report(sourceContext, IO_ERROR, format("--target {}: expected LOCALE=FILE", *it));
             return false;
         }
+        EntryContext context = sourceContext;
+        context.targetLocale = it->substr(0, equals);
+        context.targetFile = it->substr(equals + 1);
+        contexts.push_back(context);
     }
     return true;
 }
 
-bool variantExistsFor(const std::vector<Variant>& variants,
-                      const std::vector<UnicodeString>& keys) {
-    // Special case: it's OK to omit the 'other' variant if a '*'
-    // variant is present (which is checked separately.)
-    if (allOther(keys)) {
-        return true;
+// Validates the source message in `sourceFilename` against each of `targets`, given
+// as LOCALE=FILE. The source message is parsed and checked only once.
+// Prints one result record per target, and returns the exit code
+// of the first target that failed (or 0 if all targets passed)
+int validateTargets(const Locale& sourceLocale, const std::string& sourceFilename,
+                    const std::vector<std::string>& targets, int jobs, bool verbose) {
+    EntryContext sourceContext { "", localeToString(sourceLocale), "", sourceFilename, "" };
+    std::vector<EntryContext> contexts;
+    if (!parseTargets(targets, sourceContext, contexts)) {
+        return IO_ERROR;
     }
 
-    for (auto it = variants.begin(); it != variants.end(); ++it) {
-        const std::vector<Key> sKeys = it->getKeys().getKeys();
-        if (sKeys.size() != keys.size()) {
-            log("Warning: variant has fewer keys than there are selectors");
-            return false;
-        }
-        if (allWildcards(sKeys)) {
-            continue;
+    MappedFile sourceFile;
+    if (!sourceFile.open(sourceFilename)) {
+        report(sourceContext, IO_ERROR, format("Error reading from file {}", sourceFilename));
+        return IO_ERROR;
+    }
+    const SourceAnalysis source(sourceLocale, sourceFile.contents());
+
+    Batch batch(jobs);
+    for (auto it = contexts.begin(); it != contexts.end(); ++it) {
+        batch.add([&source, context = *it, verbose](std::ostream& out) {
+                      if (outputFormat == FORMAT_TEXT) {
+                          log(out, format("=== Target locale {} ===", context.targetLocale));
+                      }
+                      MappedFile targetFile;
+                      if (!targetFile.open(context.targetFile)) {
+                          report(out, context, { IO_ERROR, format("Error reading from file {}", context.targetFile),
+                                  ROLE_TARGET });
+                          return countFailure(IO_ERROR);
+                      }
+                      Locale targetLocale(context.targetLocale.c_str());
+                      if (verbose && outputFormat == FORMAT_TEXT) {
+                          echoOptions(out, source.locale(), targetLocale, source.message(), targetFile.contents());
+                      }
+                      return logResult(out, context, runTargetValidation(source, targetLocale, targetFile.contents()));
+                  }, *it, it->targetFile.size());
+    }
+    return batch.finish("targets");
+}
+
+// A message file or catalog in --watch mode, with the messages it held
+// when it was last read successfully
+struct WatchedFile {
+    std::string filename;
+    bool catalog;
+    // By message ID. A message file's one message has the ID "".
+    std::map<std::string, std::string> messages;
+};
+
+// Reads `file` again, and adds the IDs of the messages that were added, removed
+// or changed since it was last read to `changed`. If the file can't be read,
+// reports why, as a problem with `context`, and leaves its messages as they were;
+// an editor may be partway through saving it.
+void reloadWatchedFile(WatchedFile& file, const EntryContext& context, std::set<std::string>& changed) {
+    MappedFile mappedFile;
+    if (!mappedFile.open(file.filename)) {
+        report(context, IO_ERROR, format("Error reading from file {}", file.filename));
+        return;
+    }
+    std::map<std::string, std::string> messages;
+    if (file.catalog) {
+        CatalogReader reader(mappedFile.contents(), catalogFormatFor(file.filename));
+        std::string id;
+        std::string message;
+        // As in catalog mode, the last of several messages with the same ID is used
+        while (reader.next(id, message)) {
+            messages[id] = message;
         }
-        if (partialWildcards(sKeys)) {
-            return false;
+        if (!reader.error().empty()) {
+            report(context, IO_ERROR, format("{}: {}", file.filename, reader.error()));
+            return;
         }
-        if (keysEqual(sKeys, keys)) {
-            return true;
+    } else {
+        messages[""] = mappedFile.contents();
+    }
+
+    // Both maps are sorted by ID, so they can be compared in one pass
+    auto oldIt = file.messages.begin();
+    auto newIt = messages.begin();
+    while (oldIt != file.messages.end() || newIt != messages.end()) {
+        if (newIt == messages.end() || (oldIt != file.messages.end() && oldIt->first < newIt->first)) {
+            changed.insert(oldIt->first);
+            ++oldIt;
+        } else if (oldIt == file.messages.end() || newIt->first < oldIt->first) {
+            changed.insert(newIt->first);
+            ++newIt;
+        } else {
+            if (oldIt->second != newIt->second) {
+                changed.insert(oldIt->first);
+            }
+            ++oldIt;
+            ++newIt;
         }
     }
-    log(format("Omitted variant: {}", uStrsToString(keys)));
-    return false;
+    file.messages = std::move(messages);
 }
 
-void checkDataModelErrors(MessageFormatter& mf) {
-    // Data model errors are reported after formatting,
-    // not after construction of the formatter; so we have to call
-    // format() to get these errors. We don't have the arguments, so
-    // there will likely be resolution errors, but we can distinguish
-    // those from data model errors easily.
-    UErrorCode errorCode = U_ZERO_ERROR;
-    std::map<UnicodeString, message2::Formattable> empty;
-    MessageArguments args(empty, errorCode);
-    mf.formatToString(args, errorCode);
-    bool dataModelError = false;
-    if (U_FAILURE(errorCode)) {
-        switch (errorCode) {
-        case U_MF_VARIANT_KEY_MISMATCH_ERROR:
-            log("Data model error: One or more variants has a different number of keys from the number of selectors.\n");
-            dataModelError = true;
-            break;
-        case U_MF_NONEXHAUSTIVE_PATTERN_ERROR:
-            log("Data model error: Missing '*' variant.\n");
-            dataModelError = true;
-            break;
-        case U_MF_MISSING_SELECTOR_ANNOTATION_ERROR:
-            log("Data model error: A selector variable refers to an expression with no annotation.\n");
-            dataModelError = true;
-            break;
-        default:
-            break;
+// Validates a source message file or catalog against one or more target message
+// files, or a target catalog, and then validates again each time one of them is
+// saved, until the process is interrupted. Source messages stay analyzed from one
+// change to the next, and only the entries whose source or target message changed
+// are validated again; a changed source message revalidates all of its targets.
+class WatchSession {
+public:
+    // `sourceContext` names the source file or catalog, and each of `targetContexts`
+    // names a target file or catalog and its locale
+    WatchSession(const Locale& sourceLocale, const EntryContext& sourceContext, bool catalogs,
+                 const std::vector<EntryContext>& targetContexts, int jobs, bool verbose)
+        : sourceLocale(sourceLocale), sourceContext(sourceContext), catalogs(catalogs),
+          targetContexts(targetContexts), jobs(jobs), verbose(verbose) {
+        source = { sourceContext.sourceFile, catalogs, {} };
+        for (auto it = targetContexts.begin(); it != targetContexts.end(); ++it) {
+            targets.push_back({ it->targetFile, catalogs, {} });
+            targetLocales.push_back(Locale(it->targetLocale.c_str()));
         }
-        // Not all data model errors are reported, just the ones related
-        // to variants.
-    }
-    if (dataModelError) {
-        exit(DATA_MODEL_ERROR);
     }
-}
 
-MFDataModel getDataModel(const Locale& locale, std::string message) {
-    UErrorCode errorCode = U_ZERO_ERROR;
-    UParseError parseError;
+    // Only returns if the files can't be watched
+    int run() {
+        // The first time around, every file counts as changed
+        std::vector<std::string> changedFiles = { source.filename };
+        for (auto it = targets.begin(); it != targets.end(); ++it) {
+            changedFiles.push_back(it->filename);
+        }
+        FileWatcher watcher;
+        std::string error;
+        for (auto it = changedFiles.begin(); it != changedFiles.end(); ++it) {
+            if (!watcher.add(*it, error)) {
+                report(sourceContext, IO_ERROR, error);
+                return IO_ERROR;
+            }
+        }
 
-    MessageFormatter::Builder builder(errorCode);
-    MessageFormatter mf = builder.setPattern(UnicodeString(message.c_str()),
-                                             parseError, errorCode)
-        .setLocale(locale)
-        // Need strict error handling so we can detect data model errors
-        .setErrorHandlingBehavior(MessageFormatter::U_MF_STRICT)
-        .build(errorCode);
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            std::set<std::string> changedSources;
+            std::vector<std::set<std::string>> changedTargets(targets.size());
+            for (auto it = changedFiles.begin(); it != changedFiles.end(); ++it) {
+                if (*it == source.filename) {
+                    reloadWatchedFile(source, sourceContext, changedSources);
+                }
+                for (size_t i = 0; i < targets.size(); i++) {
+                    if (*it == targets[i].filename) {
+                        reloadWatchedFile(targets[i], targetContexts[i], changedTargets[i]);
+                    }
+                }
+            }
+            revalidate(changedSources, changedTargets, start);
+            cout.flush();
 
-    if (U_FAILURE(errorCode)) {
-        log(format("Couldn't parse message {}", message));
-        exit(PARSE_ERROR);
+            changedFiles = watcher.wait(SETTLE_MILLIS, error);
+            if (changedFiles.empty()) {
+                report(sourceContext, IO_ERROR, error);
+                return IO_ERROR;
+            }
+        }
     }
 
-    checkDataModelErrors(mf);
-
-    return mf.getDataModel();
-}
-
-bool checkPluralCategories(const Locale& locale, bool isSource, const MFDataModel& dataModel) {
-    UErrorCode errorCode = U_ZERO_ERROR;
+private:
+    // How long to wait for more changes after a file changes, so that a
+    // save made of several writes is only validated once
+    static constexpr int SETTLE_MILLIS = 10;
+
+    // An entry is one message ID in one target
+    using EntryKey = std::pair<size_t, std::string>;
+
+    void revalidate(const std::set<std::string>& changedSources,
+                    const std::vector<std::set<std::string>>& changedTargets,
+                    std::chrono::steady_clock::time_point start) {
+        // Parsing is where most of the time goes, so source messages are analyzed
+        // on all threads before their targets are validated
+        std::vector<std::string> sourceIds(changedSources.begin(), changedSources.end());
+        std::vector<std::unique_ptr<SourceAnalysis>> sourceAnalyses(sourceIds.size());
+        parallelFor(sourceIds.size(), jobs, [this, &sourceIds, &sourceAnalyses](size_t i) {
+            auto it = source.messages.find(sourceIds[i]);
+            if (it != source.messages.end()) {
+                sourceAnalyses[i] = std::make_unique<SourceAnalysis>(sourceLocale, it->second);
+            }
+        });
+        for (size_t i = 0; i < sourceIds.size(); i++) {
+            if (sourceAnalyses[i]) {
+                analyses[sourceIds[i]] = std::move(sourceAnalyses[i]);
+            } else {
+                analyses.erase(sourceIds[i]);
+            }
+        }
 
-    std::vector<VariableName> selectors = dataModel.getSelectors();
-    int numSelectors = selectors.size();
-    if (numSelectors == 0) {
-        log(format("Warning: {} message is not made up of a .match construct. Trivially correct.",
-                        isSource ? "source" : "target"));
-        return true;
-    }
+        std::set<EntryKey> dirty;
+        for (size_t i = 0; i < targets.size(); i++) {
+            for (auto it = changedSources.begin(); it != changedSources.end(); ++it) {
+                dirty.emplace(i, *it);
+            }
+            for (auto it = changedTargets[i].begin(); it != changedTargets[i].end(); ++it) {
+                dirty.emplace(i, *it);
+            }
+        }
 
-    std::vector<Variant> variants = dataModel.getVariants();
-    // Get plural rules for this locale
-    LocalPointer<PluralRules> pluralRules(PluralRules::forLocale(locale, errorCode));
-    checkICUError(errorCode, format("Error getting plural rules for locale {}",
-                                    localeToString(locale)));
+        // Find the messages of each entry, and its place in `results`, before any
+        // entry is run, since `results` can't change while the pipeline is filling it in
+        struct Work {
+            size_t target;
+            EntryContext context;
+            const SourceAnalysis* sourceAnalysis;
+            const std::string* targetMessage;
+            int* result;
+        };
+        std::vector<Work> work;
+        for (auto it = dirty.begin(); it != dirty.end(); ++it) {
+            auto analysis = analyses.find(it->second);
+            const SourceAnalysis* sourceAnalysis = analysis == analyses.end() ? nullptr : analysis->second.get();
+            auto target = targets[it->first].messages.find(it->second);
+            const std::string* targetMessage = target == targets[it->first].messages.end() ? nullptr : &target->second;
+            // Without catalogs, a message is only missing if its file couldn't be read,
+            // which has been reported already
+            if ((!sourceAnalysis && !targetMessage) || (!catalogs && (!sourceAnalysis || !targetMessage))) {
+                results.erase(*it);
+                continue;
+            }
+            EntryContext context = targetContexts[it->first];
+            context.messageId = it->second;
+            work.push_back({ it->first, context, sourceAnalysis, targetMessage, &results[*it] });
+        }
 
-    LocalPointer<StringEnumeration> pluralCategoriesEnumeration(pluralRules->getKeywords(errorCode));
-    checkICUError(errorCode, format("Error getting categories from plural rules for locale {}",
-                                    localeToString(locale)));
+        // Only changed on the pipeline's emitter thread
+        int validated = 0;
+        int failed = 0;
+        {
+            Pipeline pipeline(jobs, std::max(1024, 64 * jobs), memoryBudget);
+            for (auto it = work.begin(); it != work.end(); ++it) {
+                const Work& entry = *it;
+                pipeline.add([this, &entry](std::ostream& out) {
+                                 return validateEntry(out, entry.context, entry.sourceAnalysis,
+                                                      targetLocales[entry.target], entry.targetMessage);
+                             },
+                             [&entry, &validated, &failed](const std::string& output, int status) {
+                                 writer->write(output + resultRecord(outputFormat, entry.context, status));
+                                 *entry.result = status;
+                                 validated++;
+                                 if (status != 0) {
+                                     failed++;
+                                 }
+                             },
+                             entry.targetMessage ? entry.targetMessage->size() : 0);
+            }
+        }
 
-    // Check that all selectors are plural; if any are non-plural, we can't check
-    // how many variants there should be
-    bool allPlural = true;
-    for (auto it = selectors.begin(); it != selectors.end(); ++it) {
-        if (!isPluralSelector(dataModel, *it)) {
-            allPlural = false;
-            break;
+        int failing = 0;
+        for (auto it = results.begin(); it != results.end(); ++it) {
+            if (it->second != 0) {
+                failing++;
+            }
+        }
+        double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::string entryName = catalogs ? "messages" : "targets";
+        if (outputFormat == FORMAT_TEXT) {
+            cout << format("{} {} validated in {:.1f} ms, {} failed; {} of {} failing in all\n",
+                           validated, entryName, millis, failed, failing, results.size());
+        } else if (outputFormat == FORMAT_JSONL) {
+            cout << format("{{\"type\":\"summary\",\"validated\":{},\"failed\":{},\"entries\":{},"
+                           "\"failing\":{},\"millis\":{:.3f}}}\n",
+                           validated, failed, results.size(), failing, millis);
         }
-    }
-    if (!allPlural) {
-        log("Message uses non-plural selectors. Can't check exhaustiveness.\n");
-        exit(NON_PLURAL_SELECTORS);
     }
 
-    // Check for partial wildcard variants (variants with multiple keys where some are wildcards
-    // and some aren't)
-    for (auto it = variants.begin(); it != variants.end(); ++it) {
-        if (partialWildcards(it->getKeys().getKeys())) {
-            log("Partial wildcard variant is present; not all permutations of categories are explicitly enumerated.\n");
-            exit(PARTIAL_WILDCARDS);
+    // Validates one entry, either of whose messages may be missing if the files are catalogs
+    int validateEntry(std::ostream& out, const EntryContext& context, const SourceAnalysis* sourceAnalysis,
+                      const Locale& targetLocale, const std::string* targetMessage) const {
+        if (!sourceAnalysis) {
+            report(out, context, { CATALOG_MISMATCH,
+                    format("Message ID {} is in the target catalog but not the source catalog", context.messageId),
+                    ROLE_TARGET });
+            return countFailure(CATALOG_MISMATCH);
+        }
+        if (!targetMessage) {
+            report(out, context, { CATALOG_MISMATCH,
+                    format("Message ID {} is in the source catalog but not the target catalog", context.messageId),
+                    ROLE_SOURCE });
+            return countFailure(CATALOG_MISMATCH);
+        }
+        if (outputFormat == FORMAT_TEXT) {
+            log(out, catalogs ? format("=== Message ID {} ===", context.messageId)
+                              : format("=== Target locale {} ===", context.targetLocale));
         }
+        if (verbose && outputFormat == FORMAT_TEXT) {
+            echoOptions(out, sourceLocale, targetLocale, sourceAnalysis->message(), *targetMessage);
+        }
+        return logResult(out, context, runTargetValidation(*sourceAnalysis, targetLocale, *targetMessage));
     }
 
-    // Convert pluralCategoriesEnumeration to a vector for convenience
-    std::vector<UnicodeString> pluralCategories = stringEnumerationToVector(*pluralCategoriesEnumeration);
+    Locale sourceLocale;
+    EntryContext sourceContext;
+    bool catalogs;
+    std::vector<EntryContext> targetContexts;
+    std::vector<Locale> targetLocales;
+    int jobs;
+    bool verbose;
 
-    // Generate all n-permutations of plural categories, where n is the number of selectors
-    std::vector<std::vector<UnicodeString>> permutations = generatePermutations(numSelectors, pluralCategories);
-    // Consistency check
-#ifdef DEBUG
-    int categoryCount = pluralCategories.size();
-    int expectedPerms = perms(categoryCount, numSelectors);
-    if (permutations.size() != expectedPerms) {
-        log(format("Error calculating permutations of plural categories (this is a bug)\n\
-Actual size: {}\nExpected size: {}\n", permutations.size(), expectedPerms));
-        exit(ASSERTION_FAILED);
+    WatchedFile source;
+    std::vector<WatchedFile> targets;
+    // The analysis of each source message, by message ID
+    std::map<std::string, std::unique_ptr<SourceAnalysis>> analyses;
+    // The exit code of each entry
+    std::map<EntryKey, int> results;
+};
+
+// Sets up --watch for the mode the other options select. Only returns if
+// there is a problem with the options or the files can't be watched.
+int watch(const Options& opts) {
+    if (!opts.manifestFilename.empty() || opts.serve) {
+        log("--watch works with catalogs, --target, or a single pair of message files");
+        return IO_ERROR;
     }
-#endif
-
-    bool allOK = true;
-    // It's OK if a variant all of whose keys are `other` is missing
-    int32_t expectedSize = permutations.size() + 1;
-    if (missingOtherVariant(variants)) {
-        expectedSize--;
+    if (opts.format == FORMAT_SARIF) {
+        log("--watch doesn't work with --format=sarif");
+        return IO_ERROR;
     }
-
-    // Check that the number of variants == the number of permutations plus 1
-    if (variants.size() != expectedSize) {
-        log(format("Incorrect number of variants; there are {} and should\
- be {} including the wildcard variant.", variants.size(), expectedSize));
-        allOK = false;
+    std::string sourceLocaleTag = localeToString(opts.sourceLocale);
+    if (!opts.sourceCatalogFilename.empty() || !opts.targetCatalogFilename.empty()) {
+        EntryContext catalogContext { "", sourceLocaleTag, localeToString(opts.targetLocale),
+                                      opts.sourceCatalogFilename, opts.targetCatalogFilename };
+        return WatchSession(opts.sourceLocale, catalogContext, true, { catalogContext }, opts.jobs, opts.verbose).run();
     }
-
-    // Check that each permutation has a corresponding variant
-    for (auto it = permutations.begin(); it != permutations.end(); ++it) {
-        allOK &= variantExistsFor(variants, *it);
+    EntryContext sourceContext { "", sourceLocaleTag, "", opts.sourceFilename, "" };
+    std::vector<EntryContext> targetContexts;
+    if (opts.targets.empty()) {
+        targetContexts.push_back({ "", sourceLocaleTag, localeToString(opts.targetLocale),
+                                   opts.sourceFilename, opts.targetFilename });
+    } else if (!parseTargets(opts.targets, sourceContext, targetContexts)) {
+        return IO_ERROR;
     }
-
-    // Check for keys that aren't valid plural category names
-    allOK &= checkValidKeys(locale, variants, pluralCategories);
-    return allOK;
+    return WatchSession(opts.sourceLocale, sourceContext, false, targetContexts, opts.jobs, opts.verbose).run();
 }
 
-std::vector<UnicodeString> collectPlaceholders(const MFDataModel& dataModel) {
-    // This collects the placeholders from the first variant,
-    // then warns if any other variants use different placeholders.
-    std::vector<Variant> variants = dataModel.getVariants();
-    std::vector<UnicodeString> placeholders;
-    bool first = true;
-    for (auto variant = variants.begin(); variant != variants.end(); ++variant) {
-        const Pattern& pat = variant->getPattern();
-        for (auto patternPart = pat.begin(); patternPart != pat.end(); ++patternPart) {
-            if (std::holds_alternative<Expression>(*patternPart)) {
-                const Expression& expr = std::get<Expression>(*patternPart);
-                 if (expr.getOperand().isVariable()) {
-                     const VariableName& placeholder = expr.getOperand().asVariable();
-                     if (!contains(placeholders, placeholder) && !first) {
-                         log(format("Warning: not all variants in source message\
- contain the same set of placeholders. The placeholder ${} does not appear in\
- every variant.",
-                                         fromUStr(placeholder)));
-                     } else if (first) {
-                         placeholders.push_back(expr.getOperand().asVariable());
-                     }
-                }
-            }
+// Combines the shard files written by runs with --shard=i/N, for every i,
+// into the output and exit code that the unsharded run would have had
+int merge(const std::vector<std::string>& filenames, const std::string& formatName) {
+    if (filenames.empty()) {
+        log("merge needs the shard files to merge");
+        return IO_ERROR;
+    }
+    std::vector<std::unique_ptr<ShardReader>> readers;
+    std::vector<bool> seen;
+    for (auto it = filenames.begin(); it != filenames.end(); ++it) {
+        auto reader = std::make_unique<ShardReader>();
+        std::string error;
+        if (!reader->open(*it, error)) {
+            log(error);
+            return IO_ERROR;
+        }
+        const Shard& readerShard = reader->shard();
+        if (seen.empty()) {
+            seen.resize(readerShard.count);
         }
-        first = false;
+        if (readerShard.count != static_cast<int>(seen.size()) || seen[readerShard.index]) {
+            log(format("{}: shard {}/{} doesn't fit with the other shard files", *it, readerShard.index,
+                       readerShard.count));
+            return IO_ERROR;
+        }
+        if (reader->format() != formatName) {
+            log(format("{} was written with --format={}; merge with the same --format", *it, reader->format()));
+            return IO_ERROR;
+        }
+        seen[readerShard.index] = true;
+        readers.push_back(std::move(reader));
+    }
+    if (readers.size() != seen.size()) {
+        log(format("Only {} of the {} shards were given", readers.size(), seen.size()));
+        return IO_ERROR;
     }
-    return placeholders;
-}
-
-bool variantContains(const Variant& variant, const UnicodeString& placeholder) {
-    const Pattern& pat = variant.getPattern();
-    for (auto patternPart = pat.begin(); patternPart != pat.end(); ++patternPart) {
-        if (std::holds_alternative<Expression>(*patternPart)) {
-            const Expression& expr = std::get<Expression>(*patternPart);
-            if (expr.getOperand().isVariable()) {
-                if (expr.getOperand().asVariable() == placeholder) {
-                    return true;
-                }
 
+    // Each shard file is in order of entry number, so the entries can be
+    // merged one at a time, as the unsharded run would have printed them
+    std::vector<ShardEntry> heads(readers.size());
+    std::vector<bool> ended(readers.size());
+    for (size_t i = 0; i < readers.size(); i++) {
+        ended[i] = !readers[i]->next(heads[i]);
+    }
+    int aggregateResult = 0;
+    size_t entries = 0;
+    int failures = 0;
+    while (true) {
+        size_t next = readers.size();
+        for (size_t i = 0; i < readers.size(); i++) {
+            if (!ended[i] && (next == readers.size() || heads[i].number < heads[next].number)) {
+                next = i;
             }
         }
-    }
-    return false;
-}
-
-bool checkPlaceholders(const MFDataModel& sourceDataModel, const MFDataModel& targetDataModel) {
-    std::vector<UnicodeString> sourcePlaceholders = collectPlaceholders(sourceDataModel);
-    std::vector<Variant> targetVariants = targetDataModel.getVariants();
-    for (auto variant = targetVariants.begin(); variant != targetVariants.end(); ++variant) {
-        for (auto it = sourcePlaceholders.begin(); it != sourcePlaceholders.end(); ++it) {
-            if (!variantContains(*variant, *it)) {
-                log(format("In target message, variant with keys «{}» omits placeholder: ${}",
-                                keysToString(variant->getKeys().getKeys()), fromUStr(*it)));
-                return false;
+        if (next == readers.size()) {
+            break;
+        }
+        ShardEntry& entry = heads[next];
+        writer->write(entry.output);
+        entries++;
+        if (entry.status != 0) {
+            failures++;
+            if (aggregateResult == 0) {
+                aggregateResult = entry.status;
             }
         }
+        ended[next] = !readers[next]->next(entry);
     }
-    return true;
-}
-
-void reportResults(const Locale& sourceLocale, const Locale& targetLocale,
-                   bool sourceOK, bool targetOK, bool placeholdersOK) {
-    log(format("Source locale: {}",
-               localeToString(sourceLocale)));
 
-    if (sourceOK) {
-        log("Source message covers all plural categories.");
-    } else {
-        log("Source message does not cover all plural categories, or has extraneous categories.");
+    for (auto it = readers.begin(); it != readers.end(); ++it) {
+        if (!(*it)->error().empty()) {
+            log((*it)->error());
+            return IO_ERROR;
+        }
+        if ((*it)->totalEntries() != readers[0]->totalEntries()) {
+            log("The shard files disagree on the number of entries; were they all run on the same input?");
+            return IO_ERROR;
+        }
+    }
+    if (entries != readers[0]->totalEntries()) {
+        log(format("The shard files hold {} of {} entries; were they all run with the same --shard count?",
+                   entries, readers[0]->totalEntries()));
+        return IO_ERROR;
     }
 
-    log(format("Target locale: {}",
-               localeToString(targetLocale)));
+    if (outputFormat == FORMAT_TEXT) {
+        cout << format("{} {} validated, {} failed\n", entries, readers[0]->entryName(), failures);
+        cout << format("Merged {} shards\n", readers.size());
+    } else if (outputFormat == FORMAT_JSONL) {
+        cout << format("{{\"type\":\"summary\",\"validated\":{},\"failed\":{},\"shards\":{}}}\n",
+                       entries, failures, readers.size());
+    }
+    return aggregateResult;
+}
 
-    if (targetOK) {
-        log("Target message covers all plural categories.");
-    } else {
-        log("Target message does not cover all plural categories, or has extraneous categories.");
+// Serves requests on standard input, or on the Unix domain socket `socketPath` if it isn't empty.
+// Only returns at the end of standard input, or if the socket can't be set up.
+int serve(const std::string& socketPath) {
+    if (socketPath.empty()) {
+        serveStream(cin, cout, runValidation);
+        return 0;
     }
+    std::string error;
+    serveSocket(socketPath, runValidation, error);
+    log(error);
+    return IO_ERROR;
+}
 
-    if (placeholdersOK) {
-        log("All variants in target message include placeholders from source message.");
-    } else {
-        log("One or more variants in target message omit placeholders from target message.");
+// Returns false if the file can't be written
+bool writeStats(const std::string& filename) {
+    if (filename == "-") {
+        cout << stats->toJSON() << endl;
+        return true;
+    }
+    std::ofstream out(filename);
+    out << stats->toJSON() << '\n';
+    if (!out.flush()) {
+        log(format("Error writing to file {}", filename));
+        return false;
     }
+    return true;
 }
 
 int main(int argc, char** argv) {
-    Locale sourceLocale;
-    Locale targetLocale;
-    std::string sourceFilename;
-    std::string targetFilename;
-    bool verbose;
+    Options opts;
 
     // --locale_source --locale_target --message_source --message_target
     // first two flags are locale tags; second two are filenames
-    getOptions(argc, argv, sourceLocale, targetLocale,
-               sourceFilename, targetFilename, verbose, quiet);
-
-    std::string sourceMessage = readFile(sourceFilename);
-    std::string targetMessage = readFile(targetFilename);
-
-    if (verbose) {
-        echoOptions(sourceLocale, targetLocale, sourceMessage, targetMessage);
+    // Alternately, --manifest names a file listing many such entries,
+    // or --sourceCatalog and --targetCatalog name files holding many messages each,
+    // or --target (repeated) names the locale and file of each of many target messages,
+    // or --serve answers requests until standard input ends;
+    // --watch validates again whenever the files change;
+    // `merge` combines the results of runs with --shard
+    getOptions(argc, argv, opts, quiet);
+
+    // Output is buffered, and only flushed when the buffer fills up or the
+    // program exits (or after each response, in server mode)
+    std::ios::sync_with_stdio(false);
+    outputFormat = opts.format;
+    memoryBudget = opts.memoryBudget;
+    RecordWriter recordWriter(cout, opts.serve ? FORMAT_TEXT : outputFormat);
+    writer = &recordWriter;
+
+    std::unique_ptr<ResultCache> cache;
+    if (!opts.cacheDirectory.empty()) {
+        cache = std::make_unique<ResultCache>(opts.cacheDirectory);
+        resultCache = cache.get();
     }
 
-    MFDataModel sourceDataModel = getDataModel(sourceLocale, sourceMessage);
-    MFDataModel targetDataModel = getDataModel(targetLocale, targetMessage);
+    std::unique_ptr<ValidationStats> validationStats;
+    if (!opts.statsFilename.empty()) {
+        validationStats = std::make_unique<ValidationStats>();
+        stats = validationStats.get();
+    }
 
-    log("== Checking source message ==");
-    bool sourceOK = checkPluralCategories(sourceLocale, true, sourceDataModel);
-    log("== Checking target message ==");
-    bool targetOK = checkPluralCategories(targetLocale, false, targetDataModel);
-    log("== Checking placeholder consistency ==");
-    bool placeholdersOK = checkPlaceholders(sourceDataModel, targetDataModel);
+    std::unique_ptr<ShardWriter> shardFileWriter;
+    if (!opts.shard.empty()) {
+        if (!parseShard(opts.shard, shard)) {
+            log("--shard must be i/N, where 0 <= i < N");
+            return IO_ERROR;
+        }
+        if (opts.manifestFilename.empty() && opts.sourceCatalogFilename.empty()
+            && opts.targetCatalogFilename.empty() && opts.targets.empty()) {
+            log("--shard works with --manifest, catalogs and --target");
+            return IO_ERROR;
+        }
+        if (opts.watch || opts.serve || opts.shardFilename.empty()) {
+            log("--shard needs --shardFile, and doesn't work with --watch or --serve");
+            return IO_ERROR;
+        }
+        shardFileWriter = std::make_unique<ShardWriter>();
+        if (!shardFileWriter->open(opts.shardFilename, shard, opts.formatName)) {
+            log(format("Error writing to file {}", opts.shardFilename));
+            return IO_ERROR;
+        }
+        shardWriter = shardFileWriter.get();
+    }
 
-    log("== Results ==");
-    reportResults(sourceLocale, targetLocale, sourceOK, targetOK, placeholdersOK);
+    int status;
+    if (opts.command == "merge") {
+        status = merge(opts.files, opts.formatName);
+    } else if (opts.watch) {
+        status = watch(opts);
+    } else if (opts.serve) {
+        status = serve(opts.socketPath);
+    } else if (!opts.manifestFilename.empty()) {
+        status = validateManifest(opts.manifestFilename, opts.jobs, opts.verbose);
+    } else if (!opts.sourceCatalogFilename.empty() || !opts.targetCatalogFilename.empty()) {
+        status = validateCatalogs(opts.sourceLocale, opts.targetLocale,
+                                  opts.sourceCatalogFilename, opts.targetCatalogFilename, opts.jobs, opts.verbose);
+    } else if (!opts.targets.empty()) {
+        status = validateTargets(opts.sourceLocale, opts.sourceFilename, opts.targets, opts.jobs, opts.verbose);
+    } else {
+        EntryContext context { "", localeToString(opts.sourceLocale), localeToString(opts.targetLocale),
+                               opts.sourceFilename, opts.targetFilename };
+        std::ostringstream out;
+        status = validate(out, context, opts.sourceLocale, opts.targetLocale, opts.verbose);
+        writer->write(out.str());
+        if (resultCache && outputFormat == FORMAT_TEXT) {
+            log(resultCacheSummary());
+        }
+    }
+    recordWriter.finish();
 
-    return (sourceOK && targetOK && placeholdersOK) ? 0
-        : !placeholdersOK ? INCONSISTENT_PLACEHOLDERS
-        : MISSING_PLURAL_CATEGORY;
+    if (stats && !writeStats(opts.statsFilename) && status == 0) {
+        status = IO_ERROR;
+    }
+    return status;
 }
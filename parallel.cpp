@@ -0,0 +1,92 @@
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+using namespace std;
+
+// The indices [begin, end) that a thread has yet to run
+struct WorkRange {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+static bool takeFront(WorkRange& range, size_t& index) {
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.begin == range.end) {
+        return false;
+    }
+    index = range.begin++;
+    return true;
+}
+
+// Moves the back half of some other thread's range into `ranges[self]`.
+// Returns false if there was nothing left to steal.
+static bool steal(std::vector<std::unique_ptr<WorkRange>>& ranges, size_t self) {
+    for (size_t i = 1; i < ranges.size(); i++) {
+        WorkRange& victim = *ranges[(self + i) % ranges.size()];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin == victim.end) {
+                continue;
+            }
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+        WorkRange& own = *ranges[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
+
+static void worker(std::vector<std::unique_ptr<WorkRange>>& ranges, size_t self,
+                   const std::function<void(size_t)>& task) {
+    size_t index;
+    while (true) {
+        while (takeFront(*ranges[self], index)) {
+            task(index);
+        }
+        // Indices being moved between threads by a concurrent steal may be
+        // missed here, but the thread that stole them will run them
+        if (!steal(ranges, self)) {
+            return;
+        }
+    }
+}
+
+void parallelFor(size_t numTasks, int numThreads, const std::function<void(size_t)>& task) {
+    if (numThreads > 0 && static_cast<size_t>(numThreads) > numTasks) {
+        numThreads = static_cast<int>(numTasks);
+    }
+    if (numThreads <= 1) {
+        for (size_t i = 0; i < numTasks; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    std::vector<std::unique_ptr<WorkRange>> ranges;
+    for (int i = 0; i < numThreads; i++) {
+        auto range = std::make_unique<WorkRange>();
+        range->begin = numTasks * i / numThreads;
+        range->end = numTasks * (i + 1) / numThreads;
+        ranges.push_back(std::move(range));
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; i++) {
+        threads.emplace_back(worker, std::ref(ranges), i, std::cref(task));
+    }
+    worker(ranges, 0, task);
+    for (auto it = threads.begin(); it != threads.end(); ++it) {
+        it->join();
+    }
+}
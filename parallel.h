@@ -0,0 +1,15 @@
+// Work-stealing parallel loop.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Calls task(i) for every i in [0, numTasks), using `numThreads` threads
+// (including the calling thread), and returns once all calls have finished.
+//
+// Each thread starts with an equal share of the indices. A thread that runs
+// out of work steals the back half of another thread's remaining indices,
+// so threads that get cheap tasks help out threads that get expensive ones.
+// `task` must be safe to call concurrently for different indices.
+void parallelFor(size_t numTasks, int numThreads, const std::function<void(size_t)>& task);
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <sstream>
+
+#include "pipeline.h"
+
+using namespace std;
+
+Pipeline::Pipeline(int jobs, size_t maxEntries, size_t memoryBudget)
+    : maxEntries(std::max<size_t>(1, maxEntries)), memoryBudget(memoryBudget) {
+    for (int i = 0; i < std::max(1, jobs); i++) {
+        workers.emplace_back(&Pipeline::work, this);
+    }
+    emitter = std::thread(&Pipeline::emitInOrder, this);
+}
+
+Pipeline::~Pipeline() {
+    finish();
+}
+
+void Pipeline::add(Task task, Emit emit, size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    entryEmitted.wait(lock, [this, bytes] {
+        return window.empty()
+            || (window.size() < maxEntries && windowBytes + bytes <= memoryBudget);
+    });
+    window.push_back({ std::move(task), std::move(emit), bytes });
+    windowBytes += bytes;
+    queue.push_back(&window.back());
+    entryAdded.notify_one();
+}
+
+void Pipeline::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finishing) {
+            return;
+        }
+        finishing = true;
+    }
+    entryAdded.notify_all();
+    entryDone.notify_all();
+    for (auto it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    emitter.join();
+}
+
+void Pipeline::work() {
+    while (true) {
+        Entry* entry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            entryAdded.wait(lock, [this] { return !queue.empty() || finishing; });
+            if (queue.empty()) {
+                return;
+            }
+            entry = queue.front();
+            queue.pop_front();
+        }
+        std::ostringstream out;
+        int result = entry->task(out);
+        // The task's captures can be freed now; only its output is kept
+        entry->task = nullptr;
+        std::string output = out.str();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entry->output = std::move(output);
+        entry->result = result;
+        entry->done = true;
+        windowBytes += entry->output.size();
+        if (entry == &window.front()) {
+            entryDone.notify_one();
+        }
+    }
+}
+
+void Pipeline::emitInOrder() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        entryDone.wait(lock, [this] {
+            return (!window.empty() && window.front().done) || (window.empty() && finishing);
+        });
+        if (window.empty()) {
+            return;
+        }
+        // Only this thread removes entries, so the front entry stays put
+        // while it is being emitted
+        Entry& entry = window.front();
+        lock.unlock();
+        entry.emit(entry.output, entry.result);
+        lock.lock();
+        windowBytes -= entry.bytes + entry.output.size();
+        window.pop_front();
+        entryEmitted.notify_one();
+    }
+}
@@ -0,0 +1,77 @@
+// Bounded pipeline for validating a stream of entries: the caller reads
+// entries and adds them, worker threads run them, and an emitter thread
+// hands their output on in the order they were added.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The stages are connected by a window of entries that have been added but
+// not yet emitted. add() blocks while the window is full, either because it
+// holds `maxEntries` entries or because their inputs and outputs add up to
+// more than `memoryBudget` bytes, so memory use is set by the size of the
+// window rather than the number of entries, and reading overlaps with
+// validation and output.
+class Pipeline {
+public:
+    // Runs on a worker thread: writes the entry's output to the stream and
+    // returns its exit code
+    using Task = std::function<int(std::ostream&)>;
+    // Runs on the emitter thread, one entry at a time, in the order the
+    // entries were added, with the entry's output and exit code
+    using Emit = std::function<void(const std::string&, int)>;
+
+    Pipeline(int jobs, size_t maxEntries, size_t memoryBudget);
+    // Waits for the entries already added, as finish() does
+    ~Pipeline();
+
+    // `bytes` is the size of the input that `task` holds on to. A single
+    // entry that is larger than the whole budget is let through on its own.
+    void add(Task task, Emit emit, size_t bytes);
+
+    // Waits until every entry has been emitted, and stops the threads
+    void finish();
+
+private:
+    struct Entry {
+        Task task;
+        Emit emit;
+        size_t bytes;
+        std::string output;
+        int result = 0;
+        bool done = false;
+    };
+
+    void work();
+    void emitInOrder();
+
+    size_t maxEntries;
+    size_t memoryBudget;
+
+    std::mutex mutex;
+    // Signalled when an entry is added, or on finish()
+    std::condition_variable entryAdded;
+    // Signalled when an entry has run, or on finish()
+    std::condition_variable entryDone;
+    // Signalled when an entry has been emitted and removed from the window
+    std::condition_variable entryEmitted;
+    // The entries between add() and emission, oldest first. References to
+    // them stay valid while entries are added at the back and removed at
+    // the front.
+    std::deque<Entry> window;
+    // The entries in `window` that no worker has taken yet
+    std::deque<Entry*> queue;
+    size_t windowBytes = 0;
+    bool finishing = false;
+
+    std::vector<std::thread> workers;
+    std::thread emitter;
+};
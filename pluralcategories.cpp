@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include <unicode/localpointer.h>
+#include <unicode/plurrule.h>
+#include <unicode/strenum.h>
+
+#include "libmf2validate.h"
+#include "pluralcategories.h"
+#include "pluraltables.h"
+
+using namespace icu;
+using namespace std;
+
+static const char* categoryNames[NUM_PLURAL_CATEGORIES] = {
+    "zero", "one", "two", "few", "many", "other"
+};
+
+PluralCategory categoryFromString(const UnicodeString& name) {
+    for (int i = 0; i < NUM_PLURAL_CATEGORIES; i++) {
+        if (name == UnicodeString(categoryNames[i], -1, US_INV)) {
+            return static_cast<PluralCategory>(i);
+        }
+    }
+    return CATEGORY_NONE;
+}
+
+const char* categoryToString(PluralCategory category) {
+    if (category == CATEGORY_WILDCARD) {
+        return "*";
+    }
+    if (category < 0 || category >= NUM_PLURAL_CATEGORIES) {
+        return "[not a plural category]";
+    }
+    return categoryNames[category];
+}
+
+std::span<const PluralTableEntry> pluralTable() {
+    return PLURAL_TABLE;
+}
+
+static bool entryBefore(const PluralTableEntry& entry, std::string_view locale) {
+    return std::string_view(entry.locale) < locale;
+}
+
+static_assert(std::is_sorted(std::begin(PLURAL_TABLE), std::end(PLURAL_TABLE),
+                             [](const PluralTableEntry& a, const PluralTableEntry& b) {
+                                 return std::string_view(a.locale) < std::string_view(b.locale);
+                             }),
+              "PLURAL_TABLE must be sorted by locale name");
+
+// Returns nullptr if `locale` isn't in the table
+static const LocalePluralCategories* lookUpTable(const char* locale) {
+    auto it = std::lower_bound(std::begin(PLURAL_TABLE), std::end(PLURAL_TABLE), std::string_view(locale),
+                               entryBefore);
+    if (it == std::end(PLURAL_TABLE) || std::string_view(it->locale) != locale) {
+        return nullptr;
+    }
+    return &it->categories;
+}
+
+// For locales that aren't in the table
+struct ComputedPluralCategories {
+    LocalePluralCategories categories;
+    PluralCategory storage[NUM_PLURAL_CATEGORIES];
+};
+
+// Lookups only need a shared lock, so that threads only wait for each
+// other when a locale is seen for the first time
+static std::shared_mutex cacheMutex;
+// Every distinct list of categories seen so far, keyed by the categories in
+// order. There are few of them (at most one per ordered subset of the six
+// categories), and locales with the same categories share one entry.
+static std::map<std::string, std::unique_ptr<ComputedPluralCategories>> categoryLists;
+// Keyed by the locale's full name, since some regional variants
+// (for example, pt-PT) have different plural rules from the language.
+// Locales seen after the cache is full are computed again on every call,
+// so that a stream of made-up locale names can't grow it without limit.
+static std::map<std::string, const LocalePluralCategories*> cache;
+static constexpr size_t MAX_CACHED_LOCALES = 1024;
+static std::atomic<uint64_t> cacheHits;
+static std::atomic<uint64_t> cacheMisses;
+
+LocalePluralCategories computePluralCategories(const Locale& locale,
+                                               PluralCategory (&storage)[NUM_PLURAL_CATEGORIES],
+                                               UErrorCode& errorCode) {
+    LocalePluralCategories result;
+    LocalPointer<PluralRules> rules(PluralRules::forLocale(locale, errorCode));
+    if (U_FAILURE(errorCode)) {
+        return result;
+    }
+    LocalPointer<StringEnumeration> keywords(rules->getKeywords(errorCode));
+    if (U_FAILURE(errorCode)) {
+        return result;
+    }
+    size_t numCategories = 0;
+    const UnicodeString* keyword;
+    while ((keyword = keywords->snext(errorCode)) != nullptr) {
+        PluralCategory category = categoryFromString(*keyword);
+        if (category == CATEGORY_NONE || numCategories == NUM_PLURAL_CATEGORIES) {
+            // Only CLDR plural rules are supported
+            errorCode = U_UNSUPPORTED_ERROR;
+        }
+        if (U_FAILURE(errorCode)) {
+            return result;
+        }
+        storage[numCategories++] = category;
+        result.mask |= 1u << category;
+    }
+    result.categories = std::span<const PluralCategory>(storage, numCategories);
+    return result;
+}
+
+// Returns the shared copy of `categories`. Must be called with cacheMutex held exclusively.
+static const LocalePluralCategories* internCategories(const LocalePluralCategories& categories) {
+    std::string key(categories.categories.begin(), categories.categories.end());
+    auto [it, added] = categoryLists.try_emplace(key);
+    if (added) {
+        auto entry = std::make_unique<ComputedPluralCategories>();
+        std::copy(categories.categories.begin(), categories.categories.end(), entry->storage);
+        entry->categories.categories = std::span<const PluralCategory>(entry->storage, categories.categories.size());
+        entry->categories.mask = categories.mask;
+        it->second = std::move(entry);
+    }
+    return &it->second->categories;
+}
+
+const LocalePluralCategories* getPluralCategories(const Locale& locale, UErrorCode& errorCode) {
+    if (U_FAILURE(errorCode)) {
+        return nullptr;
+    }
+    if (const LocalePluralCategories* categories = lookUpTable(locale.getName())) {
+        cacheHits.fetch_add(1, std::memory_order_relaxed);
+        return categories;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(cacheMutex);
+        auto it = cache.find(locale.getName());
+        if (it != cache.end()) {
+            cacheHits.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(cacheMutex);
+    // Another thread may have added this locale since the lookup above
+    auto it = cache.find(locale.getName());
+    if (it != cache.end()) {
+        cacheHits.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+    cacheMisses.fetch_add(1, std::memory_order_relaxed);
+    PluralCategory storage[NUM_PLURAL_CATEGORIES];
+    LocalePluralCategories categories = computePluralCategories(locale, storage, errorCode);
+    if (U_FAILURE(errorCode)) {
+        return nullptr;
+    }
+    const LocalePluralCategories* result = internCategories(categories);
+    if (cache.size() < MAX_CACHED_LOCALES) {
+        cache.emplace(locale.getName(), result);
+    }
+    return result;
+}
+
+PluralCacheStats pluralCacheStats() {
+    return { cacheHits.load(), cacheMisses.load() };
+}
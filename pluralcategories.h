@@ -0,0 +1,69 @@
+// Per-locale cache of plural rules and plural categories.
+//
+// Plural category names are interned as small integers, so that
+// variant keys can be compared without comparing strings.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <unicode/locid.h>
+#include <unicode/unistr.h>
+
+// The CLDR plural categories
+enum PluralCategory : int8_t {
+    CATEGORY_ZERO,
+    CATEGORY_ONE,
+    CATEGORY_TWO,
+    CATEGORY_FEW,
+    CATEGORY_MANY,
+    CATEGORY_OTHER,
+    NUM_PLURAL_CATEGORIES,
+    // A variant key that isn't the name of any plural category
+    CATEGORY_NONE = -1,
+    // A `*` variant key
+    CATEGORY_WILDCARD = -2
+};
+
+// Returns CATEGORY_NONE if `name` isn't a plural category name
+PluralCategory categoryFromString(const icu::UnicodeString& name);
+
+const char* categoryToString(PluralCategory category);
+
+// The cardinal plural categories of a locale
+struct LocalePluralCategories {
+    // In the order that ICU returns them
+    std::span<const PluralCategory> categories;
+    // Bit `c` is set if `c` is one of `categories`
+    uint32_t mask = 0;
+
+    bool contains(PluralCategory category) const {
+        return category >= 0 && (mask & (1u << category)) != 0;
+    }
+};
+
+// One entry in the table, generated at build time from ICU's data, of the
+// plural categories of every locale that ICU has data for
+struct PluralTableEntry {
+    // As returned by Locale::getName()
+    const char* locale;
+    LocalePluralCategories categories;
+};
+
+// Returns the generated table, sorted by locale name
+std::span<const PluralTableEntry> pluralTable();
+
+// Returns the plural categories for `locale`. Locales in the generated table are
+// looked up without allocating or locking; others are computed with ICU on first
+// use and cached, up to a fixed number of locales. Entries are never evicted,
+// so the returned pointer stays valid for the life of the process. Safe to call
+// from multiple threads.
+// Sets `errorCode` and returns nullptr on failure.
+const LocalePluralCategories* getPluralCategories(const icu::Locale& locale, UErrorCode& errorCode);
+
+// Computes the plural categories for `locale` with ICU, bypassing the table
+// and the cache. `storage` holds the categories that the result refers to.
+LocalePluralCategories computePluralCategories(const icu::Locale& locale,
+                                               PluralCategory (&storage)[NUM_PLURAL_CATEGORIES],
+                                               UErrorCode& errorCode);
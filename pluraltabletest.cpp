@@ -0,0 +1,47 @@
+// Checks that the generated plural category tables (pluraltables.h) agree
+// with the plural rules of the ICU that the program runs against, so that
+// they can't silently drift from ICU's data when ICU is updated.
+//
+// Exits with 1, listing the locales that differ, if any do.
+
+#include <format>
+#include <iostream>
+
+#include <unicode/locid.h>
+
+#include "pluralcategories.h"
+
+using namespace icu;
+using namespace std;
+
+static std::string categoriesToString(std::span<const PluralCategory> categories) {
+    std::string result;
+    for (auto it = categories.begin(); it != categories.end(); ++it) {
+        result += format("{}{}", it == categories.begin() ? "" : " ", categoryToString(*it));
+    }
+    return result;
+}
+
+int main() {
+    std::span<const PluralTableEntry> table = pluralTable();
+    int failures = 0;
+    for (auto it = table.begin(); it != table.end(); ++it) {
+        UErrorCode errorCode = U_ZERO_ERROR;
+        PluralCategory storage[NUM_PLURAL_CATEGORIES];
+        LocalePluralCategories expected = computePluralCategories(Locale(it->locale), storage, errorCode);
+        if (U_FAILURE(errorCode)) {
+            failures++;
+            cout << format("*** Test failed ***: locale \"{}\": ICU error {}\n", it->locale, u_errorName(errorCode));
+            continue;
+        }
+        std::string tableCategories = categoriesToString(it->categories.categories);
+        std::string icuCategories = categoriesToString(expected.categories);
+        if (tableCategories != icuCategories || it->categories.mask != expected.mask) {
+            failures++;
+            cout << format("*** Test failed ***: locale \"{}\": table has ({}), ICU has ({})\n", it->locale,
+                           tableCategories, icuCategories);
+        }
+    }
+    cout << format("{} locales in plural table checked, {} differ from ICU\n", table.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
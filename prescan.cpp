@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <cstring>
+
+#include "prescan.h"
+
+using namespace std;
+
+// The bytes that end a run of plain text: the start and end of a placeholder,
+// an escape, and NUL, which isn't allowed in a message
+static bool isSpecial(char c) {
+    return c == '{' || c == '}' || c == '\\' || c == '\0';
+}
+
+static constexpr uint64_t ONES = 0x0101010101010101;
+static constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+
+// True if any byte of `word` is zero
+static bool hasZeroByte(uint64_t word) {
+    return ((word - ONES) & ~word & HIGH_BITS) != 0;
+}
+
+// True if any byte of `word` is one of the special bytes
+static bool hasSpecialByte(uint64_t word) {
+    return hasZeroByte(word ^ (ONES * '{')) || hasZeroByte(word ^ (ONES * '}'))
+        || hasZeroByte(word ^ (ONES * '\\')) || hasZeroByte(word);
+}
+
+// Returns the index of the first special byte at or after `i`, or message.size().
+// Text is skipped eight bytes at a time, since most of a message is plain text.
+static size_t skipText(std::string_view message, size_t i) {
+    while (i + sizeof(uint64_t) <= message.size()) {
+        uint64_t word;
+        std::memcpy(&word, message.data() + i, sizeof(word));
+        if (hasSpecialByte(word)) {
+            break;
+        }
+        i += sizeof(word);
+    }
+    while (i < message.size() && !isSpecial(message[i])) {
+        i++;
+    }
+    return i;
+}
+
+static bool isAsciiAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isNameStart(char c) {
+    return isAsciiAlpha(c) || c == '_';
+}
+
+static bool isNameChar(char c) {
+    return isNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Skips a placeholder of the form `{ $name }` starting at `i`, with optional
+// spaces. Returns false if there is no such placeholder at `i`.
+static bool skipVariable(std::string_view message, size_t& i) {
+    // message[i] == '{'
+    i++;
+    while (i < message.size() && isSpace(message[i])) {
+        i++;
+    }
+    if (i + 1 >= message.size() || message[i] != '$' || !isNameStart(message[i + 1])) {
+        return false;
+    }
+    i += 2;
+    while (i < message.size() && isNameChar(message[i])) {
+        i++;
+    }
+    while (i < message.size() && isSpace(message[i])) {
+        i++;
+    }
+    if (i == message.size() || message[i] != '}') {
+        return false;
+    }
+    i++;
+    return true;
+}
+
+bool isSimpleMessage(std::string_view message) {
+    // A complex message starts with `.` or `{{`, possibly after whitespace
+    if (message.empty() || message[0] == '.' || isSpace(message[0])) {
+        return false;
+    }
+    size_t i = 0;
+    while (true) {
+        i = skipText(message, i);
+        if (i == message.size()) {
+            return true;
+        }
+        switch (message[i]) {
+        case '{':
+            if (!skipVariable(message, i)) {
+                return false;
+            }
+            break;
+        case '\\':
+            if (i + 1 == message.size() || !(message[i + 1] == '{' || message[i + 1] == '}'
+                                             || message[i + 1] == '|' || message[i + 1] == '\\')) {
+                return false;
+            }
+            i += 2;
+            break;
+        default:
+            return false;
+        }
+    }
+}
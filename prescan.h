@@ -0,0 +1,15 @@
+// A quick scan of a message's raw UTF-8 bytes that recognizes simple
+// messages: ones with no declarations and no `.match`, whose placeholders
+// are all plain variable references like `{$name}`. Such a message always
+// parses, has no selectors and no variants, and so passes every check
+// trivially, without needing to be parsed by ICU.
+//
+// The scan is deliberately conservative: anything it isn't sure about,
+// such as escapes other than `\{`, `\}`, `\|` and `\\`, function
+// annotations, markup or leading whitespace, is left to the full parse.
+
+#pragma once
+
+#include <string_view>
+
+bool isSimpleMessage(std::string_view message);
@@ -0,0 +1,124 @@
+#include <format>
+
+#include "json.h"
+#include "report.h"
+
+using namespace std;
+
+bool outputFormatFromString(const std::string& name, OutputFormat& format) {
+    if (name == "text") {
+        format = FORMAT_TEXT;
+    } else if (name == "jsonl") {
+        format = FORMAT_JSONL;
+    } else if (name == "sarif") {
+        format = FORMAT_SARIF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Fields common to JSON Lines records, each followed by a comma
+static std::string contextFields(const EntryContext& context) {
+    std::string fields;
+    if (!context.messageId.empty()) {
+        fields += format("\"messageId\":{},", jsonString(context.messageId));
+    }
+    fields += format("\"sourceLocale\":{},\"targetLocale\":{},\"sourceFile\":{},\"targetFile\":{},",
+                     jsonString(context.sourceLocale), jsonString(context.targetLocale),
+                     jsonString(context.sourceFile), jsonString(context.targetFile));
+    return fields;
+}
+
+// A SARIF result; SARIF has no notion of a pair of files, so the location is the file
+// that the diagnostic is about (the target file, if it's about neither message in particular)
+static std::string sarifResult(const EntryContext& context, const Diagnostic& diagnostic) {
+    bool isSource = diagnostic.role == ROLE_SOURCE;
+    std::string logicalLocation;
+    if (!context.messageId.empty() || !diagnostic.variantKeys.empty()) {
+        std::string name = context.messageId;
+        if (!diagnostic.variantKeys.empty()) {
+            name += (name.empty() ? "" : " ") + format("[{}]", diagnostic.variantKeys);
+        }
+        logicalLocation = format(",\"logicalLocations\":[{{\"name\":{}}}]", jsonString(name));
+    }
+    return format("{{\"ruleId\":\"{}\",\"level\":\"error\",\"message\":{{\"text\":{}}},"
+                  "\"locations\":[{{\"physicalLocation\":{{\"artifactLocation\":{{\"uri\":{}}}}}{}}}],"
+                  "\"properties\":{{\"code\":{},\"locale\":{},\"variantKeys\":{}}}}}\n",
+                  exitCodeToString(diagnostic.code), jsonString(diagnostic.message),
+                  jsonString(isSource ? context.sourceFile : context.targetFile), logicalLocation,
+                  diagnostic.code, jsonString(isSource ? context.sourceLocale : context.targetLocale),
+                  jsonString(diagnostic.variantKeys));
+}
+
+std::string diagnosticRecord(OutputFormat format, const EntryContext& context, const Diagnostic& diagnostic) {
+    switch (format) {
+    case FORMAT_TEXT:
+        return diagnostic.message + "\n";
+    case FORMAT_SARIF:
+        return sarifResult(context, diagnostic);
+    default:
+        break;
+    }
+    std::string record = "{\"type\":\"diagnostic\"," + contextFields(context);
+    if (diagnostic.role != ROLE_NONE) {
+        bool isSource = diagnostic.role == ROLE_SOURCE;
+        record += std::format("\"role\":\"{}\",\"file\":{},\"locale\":{},", isSource ? "source" : "target",
+                              jsonString(isSource ? context.sourceFile : context.targetFile),
+                              jsonString(isSource ? context.sourceLocale : context.targetLocale));
+    }
+    if (!diagnostic.variantKeys.empty()) {
+        record += std::format("\"variantKeys\":{},", jsonString(diagnostic.variantKeys));
+    }
+    record += std::format("\"code\":{},\"name\":\"{}\",\"message\":{}}}\n", diagnostic.code,
+                          diagnostic.code == 0 ? "" : exitCodeToString(diagnostic.code),
+                          jsonString(diagnostic.message));
+    return record;
+}
+
+std::string resultRecord(OutputFormat format, const EntryContext& context, int status) {
+    switch (format) {
+    case FORMAT_TEXT:
+        if (!context.messageId.empty()) {
+            return std::format("{}\t{}\t{}\n", status == 0 ? "OK" : "FAIL", status, context.messageId);
+        }
+        return std::format("{}\t{}\t{}\t{}\t{}\t{}\n", status == 0 ? "OK" : "FAIL", status,
+                           context.sourceLocale, context.targetLocale, context.sourceFile, context.targetFile);
+    case FORMAT_JSONL:
+        return std::format("{{\"type\":\"result\",{}\"status\":{},\"name\":\"{}\"}}\n", contextFields(context),
+                           status, exitCodeToString(status));
+    default:
+        return "";
+    }
+}
+
+RecordWriter::RecordWriter(std::ostream& out, OutputFormat format) : out(out), format(format) {
+    if (format == FORMAT_SARIF) {
+        out << "{\"version\":\"2.1.0\",\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\","
+               "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"mf2validate\"}},\"results\":[\n";
+    }
+}
+
+void RecordWriter::write(const std::string& records) {
+    if (format != FORMAT_SARIF) {
+        out << records;
+        return;
+    }
+    // SARIF results are elements of an array, so they need commas between them
+    size_t start = 0;
+    size_t end;
+    while ((end = records.find('\n', start)) != std::string::npos) {
+        if (!firstRecord) {
+            out << ",\n";
+        }
+        firstRecord = false;
+        out.write(records.data() + start, end - start);
+        start = end + 1;
+    }
+}
+
+void RecordWriter::finish() {
+    if (format == FORMAT_SARIF) {
+        out << "\n]}]}\n";
+    }
+}
@@ -0,0 +1,62 @@
+// Output formats for validation results: the text that mf2validate has
+// always printed, JSON Lines, and SARIF.
+//
+// Each diagnostic, and each entry's result in batch and catalog modes, is
+// formatted as a record. In JSON Lines and SARIF formats, each record is one
+// line of JSON that identifies the file, message ID, locale and variant it
+// is about. Records are written through a RecordWriter, which buffers them
+// and, for SARIF, joins them into a single SARIF log.
+
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "libmf2validate.h"
+
+enum OutputFormat {
+    FORMAT_TEXT,
+    FORMAT_JSONL,
+    FORMAT_SARIF
+};
+
+// Returns false if `name` isn't "text", "jsonl" or "sarif"
+bool outputFormatFromString(const std::string& name, OutputFormat& format);
+
+// Identifies the pair of messages that a record is about
+struct EntryContext {
+    // Empty unless the messages come from catalogs
+    std::string messageId;
+    std::string sourceLocale;
+    std::string targetLocale;
+    // The files the messages were read from
+    std::string sourceFile;
+    std::string targetFile;
+};
+
+// Returns the record for `diagnostic`, ending in a newline
+std::string diagnosticRecord(OutputFormat format, const EntryContext& context, const Diagnostic& diagnostic);
+
+// Returns the record for the result of one entry in batch or catalog mode, ending in a newline.
+// In text format this is a tab-separated line starting with OK or FAIL and the exit code;
+// there are no result records in SARIF format.
+std::string resultRecord(OutputFormat format, const EntryContext& context, int status);
+
+// Writes records to `out`. For SARIF, the records become the results of a
+// single run, and the log isn't complete until finish() is called.
+// Nothing is flushed until the caller flushes `out`.
+class RecordWriter {
+public:
+    RecordWriter(std::ostream& out, OutputFormat format);
+
+    // `records` is any number of records, each ending in a newline
+    void write(const std::string& records);
+
+    // Must be called once all records have been written
+    void finish();
+
+private:
+    std::ostream& out;
+    OutputFormat format;
+    bool firstRecord = true;
+};
@@ -0,0 +1,204 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <unicode/ulocdata.h>
+#include <unicode/uversion.h>
+
+#include "pluralcategories.h"
+#include "resultcache.h"
+
+using namespace icu;
+using namespace std;
+
+// First line of every cache entry; change it if the entry format changes
+static const char* ENTRY_HEADER = "mf2validate result v2";
+
+// 128-bit FNV-1a. Each field is preceded by its length, so that
+// no two different sequences of fields are hashed as the same bytes.
+class KeyHasher {
+public:
+    void add(std::string_view field) {
+        uint64_t length = field.size();
+        addBytes(reinterpret_cast<const char*>(&length), sizeof(length));
+        addBytes(field.data(), field.size());
+    }
+
+    std::string hex() const {
+        return format("{:016x}{:016x}", static_cast<uint64_t>(hash >> 64), static_cast<uint64_t>(hash));
+    }
+
+private:
+    void addBytes(const char* bytes, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= PRIME;
+        }
+    }
+
+    static constexpr unsigned __int128 PRIME = (static_cast<unsigned __int128>(1) << 88) + 0x13B;
+    unsigned __int128 hash = (static_cast<unsigned __int128>(0x6c62272e07bb0142) << 64) + 0x62b821756295c58d;
+};
+
+static std::string versionToString(const UVersionInfo version) {
+    char buffer[U_MAX_VERSION_STRING_LENGTH];
+    u_versionToString(version, buffer);
+    return buffer;
+}
+
+// The categories, in order, which is all that a result depends on
+static std::string_view categoriesKey(const LocalePluralCategories& categories) {
+    return std::string_view(reinterpret_cast<const char*>(categories.categories.data()),
+                            categories.categories.size());
+}
+
+ResultCache::ResultCache(std::string directory) : directory(std::move(directory)) {
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+
+    UVersionInfo version;
+    u_getVersion(version);
+    icuVersion = "ICU " + versionToString(version);
+    UErrorCode errorCode = U_ZERO_ERROR;
+    ulocdata_getCLDRVersion(version, &errorCode);
+    if (U_SUCCESS(errorCode)) {
+        icuVersion += " CLDR " + versionToString(version);
+    }
+}
+
+std::string ResultCache::key(const Locale& sourceLocale, const Locale& targetLocale,
+                             std::string_view sourceMessage, std::string_view targetMessage) const {
+    // The plural categories are part of the key, so that results are recomputed if
+    // the ICU data changes without a change in the ICU or CLDR version
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const LocalePluralCategories* sourceCategories = getPluralCategories(sourceLocale, errorCode);
+    const LocalePluralCategories* targetCategories = getPluralCategories(targetLocale, errorCode);
+    if (U_FAILURE(errorCode)) {
+        return "";
+    }
+
+    KeyHasher hasher;
+    hasher.add(std::to_string(VALIDATOR_VERSION));
+    hasher.add(icuVersion);
+    hasher.add(sourceLocale.getName());
+    hasher.add(targetLocale.getName());
+    hasher.add(categoriesKey(*sourceCategories));
+    hasher.add(categoriesKey(*targetCategories));
+    hasher.add(sourceMessage);
+    hasher.add(targetMessage);
+    return hasher.hex();
+}
+
+// Entries are spread over 256 subdirectories, so that no directory gets too big
+std::string ResultCache::entryPath(const std::string& key) const {
+    return format("{}/{}/{}", directory, key.substr(0, 2), key.substr(2));
+}
+
+// Returns false if the entry doesn't exist or can't be read
+bool ResultCache::load(const std::string& path, ValidationResult& result, uint64_t& micros) const {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    // No count or length in a well-formed entry is bigger than the file, so a
+    // bigger one means the entry is corrupt, and it is treated as a miss
+    // rather than allocated
+    in.seekg(0, std::ios::end);
+    std::streamoff fileSize = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (fileSize < 0) {
+        return false;
+    }
+    size_t maxCount = static_cast<size_t>(fileSize);
+    std::string header;
+    size_t numDiagnostics;
+    if (!std::getline(in, header) || header != ENTRY_HEADER
+        || !(in >> result.status >> micros >> numDiagnostics) || numDiagnostics > maxCount) {
+        return false;
+    }
+    result.diagnostics.resize(numDiagnostics);
+    for (auto it = result.diagnostics.begin(); it != result.diagnostics.end(); ++it) {
+        int role;
+        size_t keysLength, messageLength;
+        if (!(in >> it->code >> role >> keysLength >> messageLength) || in.get() != '\n'
+            || role < ROLE_NONE || role > ROLE_TARGET || keysLength > maxCount || messageLength > maxCount) {
+            return false;
+        }
+        it->role = static_cast<MessageRole>(role);
+        it->variantKeys.resize(keysLength);
+        it->message.resize(messageLength);
+        if (!in.read(it->variantKeys.data(), keysLength) || !in.read(it->message.data(), messageLength)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Failures are ignored, since the result can always be recomputed
+void ResultCache::store(const std::string& path, const ValidationResult& result, uint64_t micros) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    // Write to a temporary file and rename it, so that other threads and
+    // processes never see a partly-written entry
+    std::string tempPath = format("{}.{}.{}.tmp", path, getpid(), tempFiles++);
+    {
+        std::ofstream out(tempPath, std::ios::binary);
+        out << ENTRY_HEADER << '\n';
+        out << result.status << ' ' << micros << ' ' << result.diagnostics.size() << '\n';
+        for (auto it = result.diagnostics.begin(); it != result.diagnostics.end(); ++it) {
+            out << it->code << ' ' << it->role << ' ' << it->variantKeys.size() << ' ' << it->message.size() << '\n'
+                << it->variantKeys << it->message << '\n';
+        }
+        if (!out.flush()) {
+            out.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+    }
+}
+
+ValidationResult ResultCache::validateMessages(const Locale& sourceLocale, const Locale& targetLocale,
+                                               std::string_view sourceMessage, std::string_view targetMessage,
+                                               PhaseTimes* times) {
+    return lookup(key(sourceLocale, targetLocale, sourceMessage, targetMessage), [&]() {
+        return ::validateMessages(sourceLocale, targetLocale, sourceMessage, targetMessage, times);
+    });
+}
+
+ValidationResult ResultCache::validate(const SourceAnalysis& source, const Locale& targetLocale,
+                                       std::string_view targetMessage, PhaseTimes* times) {
+    return lookup(key(source.locale(), targetLocale, source.message(), targetMessage), [&]() {
+        return source.validate(targetLocale, targetMessage, times);
+    });
+}
+
+ValidationResult ResultCache::lookup(const std::string& k, const std::function<ValidationResult()>& validate) {
+    ValidationResult result;
+    uint64_t micros = 0;
+    if (!k.empty() && load(entryPath(k), result, micros)) {
+        hits++;
+        microsSaved += micros;
+        return result;
+    }
+
+    misses++;
+    auto start = std::chrono::steady_clock::now();
+    result = validate();
+    micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    if (!k.empty()) {
+        store(entryPath(k), result, micros);
+    }
+    return result;
+}
+
+ResultCacheStats ResultCache::stats() const {
+    return { hits.load(), misses.load(), microsSaved.load() / 1e6 };
+}
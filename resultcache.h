@@ -0,0 +1,69 @@
+// On-disk cache of validation results, so that messages that haven't
+// changed since the last run don't have to be parsed and checked again.
+//
+// Each result is stored in its own file, named by a hash of everything the
+// result depends on: the source and target messages and locales, the ICU
+// and CLDR versions, the plural categories of both locales, and VALIDATOR_VERSION.
+// A change to any of these changes the hash, so stale entries are never
+// read; they are simply left behind, and the cache directory can be
+// deleted at any time.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include <unicode/locid.h>
+
+#include "libmf2validate.h"
+
+struct ResultCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    // Sum of the time it took to compute the results that were found in the cache
+    double secondsSaved;
+};
+
+class ResultCache {
+public:
+    // Entries are stored under `directory`, which is created if necessary
+    explicit ResultCache(std::string directory);
+
+    // Returns the cached result for these messages if there is one, and otherwise
+    // calls ::validateMessages() and caches its result. Safe to call from multiple
+    // threads, and from multiple processes sharing a directory.
+    // `times` is passed to ::validateMessages(), and so is left alone on a hit.
+    ValidationResult validateMessages(const icu::Locale& sourceLocale, const icu::Locale& targetLocale,
+                                      std::string_view sourceMessage, std::string_view targetMessage,
+                                      PhaseTimes* times = nullptr);
+
+    // The same, for a source message analyzed once and validated against many targets;
+    // calls source.validate() on a miss
+    ValidationResult validate(const SourceAnalysis& source, const icu::Locale& targetLocale,
+                              std::string_view targetMessage, PhaseTimes* times = nullptr);
+
+    ResultCacheStats stats() const;
+
+private:
+    // Returns the empty string if the key can't be computed,
+    // in which case the result isn't cached
+    std::string key(const icu::Locale& sourceLocale, const icu::Locale& targetLocale,
+                    std::string_view sourceMessage, std::string_view targetMessage) const;
+    // Returns the entry for `key`, or the result of `validate` (which is then stored)
+    // if there is no such entry
+    ValidationResult lookup(const std::string& key, const std::function<ValidationResult()>& validate);
+    std::string entryPath(const std::string& key) const;
+    bool load(const std::string& path, ValidationResult& result, uint64_t& micros) const;
+    void store(const std::string& path, const ValidationResult& result, uint64_t micros);
+
+    std::string directory;
+    // ICU and CLDR versions, computed once
+    std::string icuVersion;
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+    std::atomic<uint64_t> microsSaved = 0;
+    std::atomic<uint64_t> tempFiles = 0;
+};
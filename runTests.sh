@@ -1,64 +1,210 @@
 #!/bin/bash
 
+# Tests of the command-line modes (batch, catalogs, server and so on), each of
+# which starts mf2validate. Cases that validate a pair of message files are in
+# test/cases, and are run in-process by mf2test; a few of them are also run
+# here, to check the plain command's exit code.
+
+FAILED=0
+
 if [[ $1 == "--verbose" ]]; then
     QUIET=""
 else
     QUIET=-q
 fi
 
+# Validates one pair of message files, to check the exit code of the plain command
+# end to end; mf2test runs the full set of cases in-process
 doTest() {
     # For now, use a fixed source and target locale for all tests
-    bash mf2validate.sh $QUIET --sourceLocale=en-US --targetLocale=cs-CZ --sourceFilename=test/$1 --targetFilename=test/$2
+    bash mf2validate.sh $QUIET --sourceLocale=en-US --targetLocale=cs-CZ --sourceFilename=test/$1 --targetFilename=test/$2 > /dev/null
     exitCode=$?
     if [ $exitCode != $3 ]; then
+        FAILED=1
         echo "*** Test failed ***: ($1, $2); expected $3 and got $exitCode"
     else
         echo "Test passed: ($1, $2)"
     fi
 }
 
+doManifestTest() {
+    bash mf2validate.sh $QUIET --manifest=test/$1 $3 > /dev/null
+    exitCode=$?
+    if [ $exitCode != $2 ]; then
+        FAILED=1
+        echo "*** Test failed ***: (manifest $1 $3); expected $2 and got $exitCode"
+    else
+        echo "Test passed: (manifest $1 $3)"
+    fi
+}
+
+doCatalogTest() {
+    bash mf2validate.sh $QUIET --sourceLocale=en-US --targetLocale=cs-CZ --sourceCatalog=test/$1 --targetCatalog=test/$2 > /dev/null
+    exitCode=$?
+    if [ $exitCode != $3 ]; then
+        FAILED=1
+        echo "*** Test failed ***: (catalogs $1, $2); expected $3 and got $exitCode"
+    else
+        echo "Test passed: (catalogs $1, $2)"
+    fi
+}
+
+# Fan-out: validates English_message_good against each LOCALE=FILE argument after the first,
+# and checks the exit code and that each target gets the same diagnostics as when validated alone
+doTargetsTest() {
+    expected=$1
+    shift
+    targetFlags=""
+    pairDiagnostics=""
+    for target in "$@"; do
+        targetFlags="$targetFlags --target=${target%%=*}=test/${target#*=}"
+        pairDiagnostics="$pairDiagnostics$(bash mf2validate.sh --format=jsonl --sourceLocale=en-US --sourceFilename=test/English_message_good \
+            --targetLocale=${target%%=*} --targetFilename=test/${target#*=} | grep '"type":"diagnostic"')"$'\n'
+    done
+    output=$(bash mf2validate.sh --format=jsonl --sourceLocale=en-US --sourceFilename=test/English_message_good $targetFlags)
+    exitCode=$?
+    targetsDiagnostics="$(echo "$output" | grep '"type":"diagnostic"')"$'\n'
+    if [ $exitCode != $expected ]; then
+        FAILED=1
+        echo "*** Test failed ***: (targets $*); expected $expected and got $exitCode"
+    elif [ "$targetsDiagnostics" != "$pairDiagnostics" ]; then
+        FAILED=1
+        echo "*** Test failed ***: (targets $*); diagnostics differ from validating each pair"
+    else
+        echo "Test passed: (targets $*)"
+    fi
+}
+
+# Sharding: runs the catalog pair $1, $2 as $3 shards and merges them, and checks that the
+# merge has the exit code $4 and the same records as the unsharded run
+doShardTest() {
+    SHARD_DIR=$(mktemp -d)
+    flags="--format=jsonl --sourceLocale=en-US --targetLocale=cs-CZ --sourceCatalog=test/$1 --targetCatalog=test/$2"
+    unsharded=$(bash mf2validate.sh $flags | grep -v '"type":"summary"')
+    shardFiles=""
+    for ((i = 0; i < $3; i++)); do
+        bash mf2validate.sh $flags --shard=$i/$3 --shardFile=$SHARD_DIR/$i > /dev/null
+        shardFiles="$shardFiles $SHARD_DIR/$i"
+    done
+    merged=$(bash mf2validate.sh --format=jsonl merge $shardFiles)
+    exitCode=$?
+    if [ $exitCode != $4 ]; then
+        FAILED=1
+        echo "*** Test failed ***: (shards $1, $2, $3); expected $4 and got $exitCode"
+    elif [ "$(echo "$merged" | grep -v '"type":"summary"')" != "$unsharded" ]; then
+        FAILED=1
+        echo "*** Test failed ***: (shards $1, $2, $3); merged records differ from the unsharded run"
+    else
+        echo "Test passed: (shards $1, $2, $3)"
+    fi
+    rm -rf $SHARD_DIR
+}
+
 # Nonexistent file
 doTest "bogus" "English_message_good" 8
 # Good source and target
 doTest "English_message_good" "Czech_message_good" 0
 # Good source, bad target
 doTest "English_message_good" "Czech_message_bad" 1
-# Bad source, bad target
-doTest "English_message_bad" "Czech_message_bad" 1
 # Parse error
 doTest "Czech_message_good" "parse_error" 2
-# Multiple selectors (good)
-doTest "English_multiple_selectors" "Czech_multiple_selectors" 0
-# Multiple selectors (bad)
-doTest "English_multiple_selectors" "Czech_multiple_selectors_bad" 1
-# Missing * variant
-doTest "English_message_good" "Czech_message_missing_wildcard" 4
-# Keyword that is not a correct plural category
-doTest "English_message_good" "Czech_message_not_plural_category" 1
-# Message without selectors
-doTest "English_message_good" "Czech_message_no_selectors" 0
-# Message with selectors but no plural selectors
-doTest "no_plural_selector" "no_plural_selector" 6
-# Good source and target with '*' variant not positioned last
-doTest "English_message_good_permuted" "Czech_message_good_permuted" 0
-# Message with both plural and non-plural selectors
-doTest "English_mixed_selectors" "Czech_mixed_selectors" 6
-# Message with partial-wildcard variants
-doTest "English_message_good" "Czech_partial_wildcards" 9
-# Message with variant key mismatch
-doTest "English_message_good" "Czech_message_variant_key_mismatch" 4
-# Message with missing selector annotation
-doTest "English_message_good" "Czech_message_missing_selector_annotation" 4
-# Message with aliased selector variable
-doTest "English_message_alias" "Czech_message_alias" 0
-# Message with additional cases that aren't plural categories (see README)
-doTest "English_message_valid_but_rejected" "Czech_message_valid_but_rejected" 1
-# Messages with inconsistent placeholders
-doTest "English_message_good" "Czech_message_inconsistent_placeholders" 10
-# Source message with different placeholders in different variants
-# (Warns, but doesn't fail)
-doTest "English_message_varying_variants" "Czech_message_good" 0
-# Missing "other" variant -- shouldn't be an error if there's a '*'
-doTest "English_message_missing_other" "Czech_message_missing_other" 0
-# Missing "other other" variant with 2 selectors
-doTest "English_message_missing_other_2" "Czech_message_missing_other_2" 0
+# Batch mode: all entries pass
+doManifestTest "manifest_good" 0
+# Batch mode: exit code of the first failing entry
+doManifestTest "manifest" 1
+# Batch mode: nonexistent manifest
+doManifestTest "bogus" 8
+# Batch mode on several threads
+doManifestTest "manifest" 1 --jobs=4
+# Batch mode with the smallest memory budget
+doManifestTest "manifest" 1 "--jobs=4 --memoryBudget=1"
+# Catalogs: all messages pass (JSON)
+doCatalogTest "English_catalog.json" "Czech_catalog.json" 0
+# Catalogs: exit code of the first failing message (text format)
+doCatalogTest "English_catalog" "Czech_catalog_bad" 1
+# Catalogs: message IDs that are only in one catalog
+doCatalogTest "English_catalog" "Czech_catalog.json" 11
+# Catalogs: syntax error
+doCatalogTest "English_catalog.json" "malformed_catalog.json" 8
+# Catalogs: \u escapes of unpaired surrogates
+doCatalogTest "English_catalog.json" "unpaired_high_surrogate_catalog.json" 8
+doCatalogTest "English_catalog.json" "unpaired_low_surrogate_catalog.json" 8
+# Sharded catalogs merge to the unsharded result
+doShardTest "English_catalog" "Czech_catalog_bad" 3 1
+doShardTest "English_catalog" "Czech_catalog.json" 2 11
+# Warnings about IDs repeated in the source catalog go into the shard files too
+doShardTest "English_catalog_duplicates" "Czech_catalog_bad" 3 1
+# Output formats don't change the result
+doManifestTest "manifest" 1 --format=jsonl
+doManifestTest "manifest" 1 --format=sarif
+# Statistics don't change the result
+doManifestTest "manifest" 1 --stats=/dev/null
+# Result cache: a second run with the same cache gives the same result
+CACHE_DIR=$(mktemp -d)
+doManifestTest "manifest" 1 --cache=$CACHE_DIR
+doManifestTest "manifest" 1 --cache=$CACHE_DIR
+# Result cache: corrupt entries, with counts and lengths far bigger than the
+# entry, are recomputed
+for entry in $(find $CACHE_DIR -type f | head -n 2); do
+    sed -i '2s/.*/0 0 1000000000000/' $entry
+done
+for entry in $(find $CACHE_DIR -type f | tail -n +3); do
+    sed -i '3s/.*/0 0 1000000000000 1000000000000/' $entry
+done
+doManifestTest "manifest" 1 --cache=$CACHE_DIR
+rm -rf $CACHE_DIR
+# Fan-out: all targets pass
+doTargetsTest 0 cs-CZ=Czech_message_good en-US=English_message_good cs-CZ=Czech_message_good_permuted
+# Fan-out: exit code of the first failing target
+doTargetsTest 1 cs-CZ=Czech_message_good cs-CZ=Czech_message_bad cs-CZ=Czech_message_missing_wildcard
+doTargetsTest 10 cs-CZ=Czech_message_placeholders_missing cs-CZ=Czech_message_bad
+# Diagnostics about a `*` variant name its key as `*`
+KEYS=$(bash mf2validate.sh --format=jsonl --sourceLocale=en-US --targetLocale=cs-CZ --sourceFilename=test/English_message_good \
+    --targetFilename=test/Czech_message_wildcard_missing_placeholder | grep -o '"variantKeys":"[^"]*"')
+if [ "$KEYS" != '"variantKeys":"*"' ]; then
+    FAILED=1
+    echo "*** Test failed ***: (wildcard variant keys); got $KEYS"
+else
+    echo "Test passed: (wildcard variant keys)"
+fi
+# Serve mode: one response per request, in order
+STATUSES=$(bash mf2validate.sh --serve < test/serve_requests | grep -o '"status":[0-9]*' | tr '\n' ' ')
+if [ "$STATUSES" != '"status":0 "status":1 "status":8 ' ]; then
+    FAILED=1
+    echo "*** Test failed ***: (serve serve_requests); got $STATUSES"
+else
+    echo "Test passed: (serve serve_requests)"
+fi
+
+# Watch mode: after a target is replaced, only that target is validated again.
+# mf2validate is started directly rather than through mf2validate.sh, so that it can be stopped.
+WATCH_DIR=$(mktemp -d)
+cp test/English_message_good test/Czech_message_good $WATCH_DIR
+LD_LIBRARY_PATH=./icu_release/usr/local/lib ./mf2validate -q --watch --format=jsonl --sourceLocale=en-US \
+    --sourceFilename=$WATCH_DIR/English_message_good --target=cs-CZ=$WATCH_DIR/Czech_message_good \
+    --target=en-GB=$WATCH_DIR/English_message_good > $WATCH_DIR/output &
+WATCH_PID=$!
+# Waits up to five seconds for the output to hold $1 summaries
+waitForSummaries() {
+    for i in $(seq 50); do
+        if [ $(grep -c '"type":"summary"' $WATCH_DIR/output) -ge $1 ]; then
+            return
+        fi
+        sleep 0.1
+    done
+}
+waitForSummaries 1
+cp test/Czech_message_bad $WATCH_DIR/Czech_message_good.new
+mv $WATCH_DIR/Czech_message_good.new $WATCH_DIR/Czech_message_good
+waitForSummaries 2
+kill $WATCH_PID
+SUMMARIES=$(grep -o '"validated":[0-9]*,"failed":[0-9]*' $WATCH_DIR/output | tr '\n' ' ')
+if [ "$SUMMARIES" != '"validated":2,"failed":0 "validated":1,"failed":1 ' ]; then
+    FAILED=1
+    echo "*** Test failed ***: (watch); got $SUMMARIES"
+else
+    echo "Test passed: (watch)"
+fi
+rm -rf $WATCH_DIR
+
+exit $FAILED
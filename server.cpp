@@ -0,0 +1,204 @@
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <semaphore>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "catalog.h"
+#include "json.h"
+#include "server.h"
+
+using namespace icu;
+using namespace std;
+
+// Longest request line a socket connection may send; a client that goes past it
+// gets an error response and is disconnected, rather than filling up memory
+static constexpr size_t MAX_REQUEST_SIZE = 1 << 20;
+// Connections served at once; more wait in the socket's listen backlog
+static constexpr ptrdiff_t MAX_CONNECTIONS = 64;
+
+static std::string errorResponse(const std::string& id, const std::string& message) {
+    return format("{{{}\"status\":{},\"diagnostics\":[{{\"code\":{},\"message\":{}}}]}}",
+                  id.empty() ? "" : format("\"id\":{},", jsonString(id)), IO_ERROR, IO_ERROR,
+                  jsonString(message));
+}
+
+std::string handleRequest(std::string_view request, const MessageValidator& validate) {
+    // A request has the same syntax as a JSON message catalog
+    CatalogReader reader(request, CATALOG_JSON);
+    std::string id, sourceLocale, targetLocale, source, target;
+    bool hasSource = false;
+    bool hasTarget = false;
+    std::string key;
+    std::string value;
+    while (reader.next(key, value)) {
+        if (key == "id") {
+            id = value;
+        } else if (key == "sourceLocale") {
+            sourceLocale = value;
+        } else if (key == "targetLocale") {
+            targetLocale = value;
+        } else if (key == "source") {
+            source = value;
+            hasSource = true;
+        } else if (key == "target") {
+            target = value;
+            hasTarget = true;
+        }
+    }
+    if (!reader.error().empty()) {
+        return errorResponse(id, format("Malformed request: {}", reader.error()));
+    }
+    if (sourceLocale.empty() || targetLocale.empty() || !hasSource || !hasTarget) {
+        return errorResponse(id, "Request must have sourceLocale, targetLocale, source and target");
+    }
+
+    ValidationResult result = validate(Locale(sourceLocale.c_str()), Locale(targetLocale.c_str()), source, target);
+
+    std::string response = "{";
+    if (!id.empty()) {
+        response += format("\"id\":{},", jsonString(id));
+    }
+    response += format("\"status\":{},\"diagnostics\":[", result.status);
+    for (auto it = result.diagnostics.begin(); it != result.diagnostics.end(); ++it) {
+        response += format("{}{{\"code\":{},\"message\":{}", it == result.diagnostics.begin() ? "" : ",",
+                           it->code, jsonString(it->message));
+        if (it->role != ROLE_NONE) {
+            response += format(",\"role\":\"{}\"", it->role == ROLE_SOURCE ? "source" : "target");
+        }
+        if (!it->variantKeys.empty()) {
+            response += format(",\"variantKeys\":{}", jsonString(it->variantKeys));
+        }
+        response += "}";
+    }
+    response += "]}";
+    return response;
+}
+
+void serveStream(std::istream& in, std::ostream& out, const MessageValidator& validate) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        out << handleRequest(line, validate) << '\n';
+        out.flush();
+    }
+}
+
+// Returns false if the client has gone away
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+static void serveConnection(int fd, MessageValidator validate) {
+    std::string pending;
+    char buffer[65536];
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        pending.append(buffer, n);
+
+        // Answer every complete line received so far with a single write
+        std::string responses;
+        size_t start = 0;
+        size_t end;
+        bool tooLong = false;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            std::string_view line(pending.data() + start, end - start);
+            if (line.size() > MAX_REQUEST_SIZE) {
+                tooLong = true;
+                break;
+            }
+            if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+                responses += handleRequest(line, validate);
+                responses += '\n';
+            }
+            start = end + 1;
+        }
+        pending.erase(0, start);
+        if (tooLong || pending.size() > MAX_REQUEST_SIZE) {
+            responses += errorResponse("", format("Request is longer than {} bytes", MAX_REQUEST_SIZE));
+            responses += '\n';
+            sendAll(fd, responses);
+            break;
+        }
+        if (!responses.empty() && !sendAll(fd, responses)) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+void serveSocket(const std::string& path, const MessageValidator& validate, std::string& error) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = format("Socket path {} is too long", path);
+        return;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // Remove a socket left behind by an earlier server, but nothing else
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+        unlink(path.c_str());
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        error = format("Error creating socket: {}", strerror(errno));
+        return;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listener, SOMAXCONN) != 0) {
+        error = format("Error listening on socket {}: {}", path, strerror(errno));
+        close(listener);
+        return;
+    }
+
+    // Shared with the connection threads, which may outlive this function
+    auto slots = std::make_shared<std::counting_semaphore<MAX_CONNECTIONS>>(MAX_CONNECTIONS);
+    while (true) {
+        // Wait for a free slot before accepting, so that excess clients
+        // wait to connect instead of each getting a thread
+        slots->acquire();
+        int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            int acceptError = errno;
+            slots->release();
+            if (acceptError == EINTR || acceptError == ECONNABORTED) {
+                continue;
+            }
+            error = format("Error accepting connection on socket {}: {}", path, strerror(acceptError));
+            close(listener);
+            return;
+        }
+        std::thread([fd, validate, slots] {
+            serveConnection(fd, validate);
+            slots->release();
+        }).detach();
+    }
+}
@@ -0,0 +1,44 @@
+// Validation server, for clients such as editors that validate one message
+// at a time and can't afford to start a process (and load ICU data) for each.
+//
+// Requests are JSON objects, one per line, whose values are all strings:
+//   {"id": "42", "sourceLocale": "en-US", "targetLocale": "cs-CZ", "source": "...", "target": "..."}
+// `id` is optional, and is echoed in the response. Each request gets one
+// response line, in the order the requests were received:
+//   {"id": "42", "status": 1, "diagnostics": [{"code": 1, "message": "...", "role": "target",
+//                                              "variantKeys": "one few"}, ...]}
+// `role` ("source" or "target") and `variantKeys` are only present if the diagnostic
+// is about one of the messages, or about one variant.
+// A request that can't be parsed gets a response with status IO_ERROR.
+//
+// Plural rules, and anything else cached by the validator, stay loaded
+// from one request to the next.
+
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <unicode/locid.h>
+
+#include "libmf2validate.h"
+
+using MessageValidator = std::function<ValidationResult(const icu::Locale& sourceLocale,
+                                                        const icu::Locale& targetLocale,
+                                                        std::string_view sourceMessage,
+                                                        std::string_view targetMessage)>;
+
+// Returns the response to one request, without a trailing newline
+std::string handleRequest(std::string_view request, const MessageValidator& validate);
+
+// Answers requests from `in` until it ends, flushing `out` after each response
+void serveStream(std::istream& in, std::ostream& out, const MessageValidator& validate);
+
+// Listens on a Unix domain socket at `path` (replacing any socket already there),
+// answering each connection's requests on its own thread, up to a fixed number
+// of connections at once. A connection that sends a request line longer than
+// a fixed limit gets an IO_ERROR response and is closed. Only returns if the
+// socket can't be set up, in which case `error` says why.
+void serveSocket(const std::string& path, const MessageValidator& validate, std::string& error);
@@ -0,0 +1,109 @@
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <sstream>
+
+#include "shard.h"
+
+using namespace std;
+
+// First line of every shard file; change it if the format changes
+static const char* SHARD_HEADER = "mf2validate shard v1";
+
+// 64-bit FNV-1a, which doesn't depend on the platform or the standard library
+static uint64_t shardHash(std::string_view key) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < key.size(); i++) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+bool Shard::contains(std::string_view key) const {
+    return shardHash(key) % count == static_cast<uint64_t>(index);
+}
+
+// Parses all of `s` as a non-negative int
+static bool parseInt(std::string_view s, int& value) {
+    auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return error == std::errc() && end == s.data() + s.size() && value >= 0;
+}
+
+bool parseShard(const std::string& spec, Shard& shard) {
+    size_t slash = spec.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    std::string_view s(spec);
+    return parseInt(s.substr(0, slash), shard.index) && parseInt(s.substr(slash + 1), shard.count)
+        && shard.index < shard.count;
+}
+
+bool ShardWriter::open(const std::string& filename, const Shard& shard, const std::string& format) {
+    filenameValue = filename;
+    out.open(filename, std::ios::binary);
+    out << SHARD_HEADER << '\n' << shard.index << ' ' << shard.count << ' ' << format << '\n';
+    return static_cast<bool>(out);
+}
+
+void ShardWriter::add(size_t number, int status, const std::string& output) {
+    out << number << ' ' << status << ' ' << output.size() << '\n' << output;
+}
+
+bool ShardWriter::finish(size_t totalEntries, const std::string& entryName) {
+    out << "end " << totalEntries << ' ' << entryName << '\n';
+    out.close();
+    return !out.fail();
+}
+
+bool ShardReader::open(const std::string& filename, std::string& error) {
+    this->filename = filename;
+    in.open(filename, std::ios::binary);
+    if (!in) {
+        error = std::format("Error reading from file {}", filename);
+        return false;
+    }
+    std::string header;
+    std::string shardLine;
+    if (!std::getline(in, header) || header != SHARD_HEADER || !std::getline(in, shardLine)) {
+        error = std::format("{} is not a shard file", filename);
+        return false;
+    }
+    std::istringstream fields(shardLine);
+    if (!(fields >> shardInfo.index >> shardInfo.count >> formatName)
+        || shardInfo.index < 0 || shardInfo.index >= shardInfo.count) {
+        error = std::format("{}: malformed shard header", filename);
+        return false;
+    }
+    return true;
+}
+
+bool ShardReader::next(ShardEntry& entry) {
+    std::string line;
+    if (!std::getline(in, line)) {
+        errorMessage = std::format("{}: file ends before its trailer; was the shard's run cut short?", filename);
+        return false;
+    }
+    std::istringstream fields(line);
+    if (line.starts_with("end ")) {
+        std::string end;
+        if (!(fields >> end >> total >> entryNameValue)) {
+            errorMessage = std::format("{}: malformed trailer", filename);
+        }
+        return false;
+    }
+    size_t number;
+    size_t length;
+    if (!(fields >> number >> entry.status >> length)) {
+        errorMessage = std::format("{}: malformed entry", filename);
+        return false;
+    }
+    entry.number = number;
+    entry.output.resize(length);
+    if (!in.read(entry.output.data(), length)) {
+        errorMessage = std::format("{}: file ends in the middle of an entry", filename);
+        return false;
+    }
+    return true;
+}
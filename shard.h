@@ -0,0 +1,96 @@
+// Splitting one validation run across several processes or machines, and
+// merging their results.
+//
+// With --shard=i/N, a run still reads all of its input, and numbers every
+// entry as the unsharded run would, but only validates the entries whose
+// shard key (the message ID in catalog mode, and the source file otherwise)
+// hashes to shard i. All the targets of one source message therefore land in
+// the same shard. The entries' output goes to a shard file, in which each entry
+// is stored under its number, so that `mf2validate merge` can interleave the
+// shard files back into the output and exit code of the unsharded run.
+//
+// A shard file is text: a header, then one entry per validated entry in
+// increasing order of number, then a trailer:
+//
+//   mf2validate shard v1
+//   <i> <N> <format>
+//   <number> <exit code> <length>
+//   <length bytes of output>
+//   ...
+//   end <number of entries in the unsharded run> <entry name>
+//
+// A run that fails partway, for example on a malformed catalog, leaves out
+// the trailer, so that its shard file can't be merged.
+//
+// The output is already formatted (as text, JSON Lines or SARIF records), so
+// all shards of a run must be given the same --format and -q, and so must the merge.
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+struct Shard {
+    int index = 0;
+    int count = 1;
+
+    // True if the entry with shard key `key` belongs to this shard. The hash
+    // is fixed, so that every process and machine agrees on it.
+    bool contains(std::string_view key) const;
+};
+
+// Parses `spec`, of the form i/N with 0 <= i < N. Returns false if it is malformed.
+bool parseShard(const std::string& spec, Shard& shard);
+
+class ShardWriter {
+public:
+    // Returns false if `filename` can't be written
+    bool open(const std::string& filename, const Shard& shard, const std::string& format);
+
+    // Adds the entry numbered `number`; numbers must increase from one call to the next
+    void add(size_t number, int status, const std::string& output);
+
+    // Writes the trailer. `entryName` is what the entries are, such as "messages".
+    // Returns false if the file couldn't be written.
+    bool finish(size_t totalEntries, const std::string& entryName);
+
+    const std::string& filename() const { return filenameValue; }
+
+private:
+    std::string filenameValue;
+    std::ofstream out;
+};
+
+struct ShardEntry {
+    size_t number;
+    int status;
+    std::string output;
+};
+
+class ShardReader {
+public:
+    // Returns false, and sets `error`, if `filename` can't be read or doesn't start with a shard header
+    bool open(const std::string& filename, std::string& error);
+
+    // Reads the next entry. Returns false after the trailer, or if the file
+    // is malformed or cut short, in which case error() is non-empty.
+    bool next(ShardEntry& entry);
+
+    const Shard& shard() const { return shardInfo; }
+    const std::string& format() const { return formatName; }
+    // Only set once next() has returned false without an error
+    size_t totalEntries() const { return total; }
+    const std::string& entryName() const { return entryNameValue; }
+    const std::string& error() const { return errorMessage; }
+
+private:
+    std::string filename;
+    std::ifstream in;
+    Shard shardInfo;
+    std::string formatName;
+    std::string entryNameValue;
+    size_t total = 0;
+    std::string errorMessage;
+};
@@ -0,0 +1,108 @@
+#include <bit>
+#include <cmath>
+#include <format>
+
+#include <sys/resource.h>
+
+#include "stats.h"
+
+using namespace std;
+
+int LatencyHistogram::bucketFor(uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) {
+        return nanos;
+    }
+    int exponent = std::bit_width(nanos) - 1;
+    int subBucket = (nanos >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t lowerBound = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return lowerBound + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    buckets[bucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t count = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        count += buckets[i].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    uint64_t rank = std::max<uint64_t>(1, std::ceil(count() * percentile / 100));
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return 0;
+}
+
+void ValidationStats::record(const PhaseTimes& times, uint64_t totalNanos, int status, uint64_t bytes) {
+    for (int phase = 0; phase < NUM_PHASES; phase++) {
+        if (times.nanos[phase] != 0) {
+            phases[phase].record(times.nanos[phase]);
+        }
+    }
+    total.record(totalNanos);
+    recordExitCode(status);
+    this->bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ValidationStats::recordExitCode(int status) {
+    exitCodes[(status >= 0 && status <= MAX_EXIT_CODE) ? status : MAX_EXIT_CODE + 1]
+        .fetch_add(1, std::memory_order_relaxed);
+}
+
+static std::string histogramToJSON(const LatencyHistogram& histogram) {
+    return format("{{\"count\":{},\"p50Nanos\":{},\"p95Nanos\":{},\"p99Nanos\":{}}}",
+                  histogram.count(), histogram.percentile(50), histogram.percentile(95),
+                  histogram.percentile(99));
+}
+
+// On Linux, ru_maxrss is in kilobytes
+uint64_t peakMemoryBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+std::string ValidationStats::toJSON() const {
+    std::string exitCodesJSON;
+    for (int i = 0; i <= MAX_EXIT_CODE + 1; i++) {
+        uint64_t count = exitCodes[i].load(std::memory_order_relaxed);
+        if (count != 0) {
+            exitCodesJSON += format("{}\"{}\":{}", exitCodesJSON.empty() ? "" : ",", exitCodeToString(i), count);
+        }
+    }
+    std::string phasesJSON;
+    for (int phase = 0; phase < NUM_PHASES; phase++) {
+        phasesJSON += format("\"{}\":{},", phaseToString(static_cast<ValidationPhase>(phase)),
+                             histogramToJSON(phases[phase]));
+    }
+    phasesJSON += format("\"total\":{}", histogramToJSON(total));
+
+    MessageMemoStats memoStats = messageMemoStats();
+    double dedupRatio = memoStats.lookups == 0 ? 0.0 : static_cast<double>(memoStats.hits) / memoStats.lookups;
+    std::string memoJSON = format("{{\"lookups\":{},\"hits\":{},\"dedupRatio\":{:.3f}}}",
+                                  memoStats.lookups, memoStats.hits, dedupRatio);
+
+    return format("{{\"validated\":{},\"bytes\":{},\"peakMemoryBytes\":{},\"exitCodes\":{{{}}},"
+                  "\"messageMemo\":{},\"phases\":{{{}}}}}",
+                  total.count(), bytes.load(std::memory_order_relaxed), peakMemoryBytes(),
+                  exitCodesJSON, memoJSON, phasesJSON);
+}
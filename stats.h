@@ -0,0 +1,60 @@
+// Statistics about a run of the validator: latency histograms for each
+// phase of validation, counts of results by exit code, the number of bytes
+// of messages validated, and the process's peak memory use.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "libmf2validate.h"
+
+// Log-linear histogram of latencies in nanoseconds: each power of two is
+// split into SUB_BUCKETS buckets, so percentiles are accurate to within
+// 1/SUB_BUCKETS of their value. Safe to update from multiple threads.
+class LatencyHistogram {
+public:
+    void record(uint64_t nanos);
+    uint64_t count() const;
+    // Returns an upper bound on the `percentile`th percentile (0 < percentile <= 100),
+    // or 0 if nothing has been recorded
+    uint64_t percentile(double percentile) const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int bucketFor(uint64_t nanos);
+    static uint64_t bucketUpperBound(int bucket);
+
+    std::atomic<uint64_t> buckets[NUM_BUCKETS] = {};
+};
+
+// The process's peak resident set size so far, or 0 if it can't be found
+uint64_t peakMemoryBytes();
+
+class ValidationStats {
+public:
+    // Records one call to validateMessages(). `times` holds the time spent in each phase,
+    // where phases that didn't run (because of an earlier failure, or because the result
+    // was cached) are 0 and aren't recorded. `totalNanos` is the time for the whole call.
+    void record(const PhaseTimes& times, uint64_t totalNanos, int status, uint64_t bytes);
+
+    // Counts an entry that failed before it could be validated, such as a file
+    // that couldn't be read
+    void recordExitCode(int status);
+
+    // Returns a JSON object holding the statistics recorded so far
+    std::string toJSON() const;
+
+private:
+    // Exit codes above this are counted together
+    static constexpr int MAX_EXIT_CODE = CATALOG_MISMATCH;
+
+    LatencyHistogram phases[NUM_PHASES];
+    LatencyHistogram total;
+    std::atomic<uint64_t> exitCodes[MAX_EXIT_CODE + 2] = {};
+    std::atomic<uint64_t> bytes = 0;
+};